@@ -9,6 +9,22 @@
 *           2016/07/11  add gsof_sat_t to gsof_t, and related functions
 *           2016/07/20  replace "CMP" with "BDS"
 *                       unify the satno() and satsys() with rtklib 2.4.3
+*           2026/10/16  add rawfile_t for memory-mapped file decoding
+*           2026/10/16  add rawidx_t/rawindex_t for raw data frame index
+*           2026/10/16  add rawcb_t for parallel file decoding
+*           2026/10/16  add msgtbl_t message decoder table to raw_t
+*           2026/10/16  add message subscription to msgtbl_t
+*           2026/10/16  add rescan of failed packet bytes to raw_t
+*           2026/10/16  add satrow_t satellite to obs row map to raw_t
+*           2026/10/16  add obscol_t observation data by columns to raw_t
+*           2026/10/16  add rawpub_t triple buffer of published epochs
+*           2026/10/16  add obspair_t dual-antenna epoch pairing to raw_t
+*           2026/10/16  add sdcol_t between-antenna single differences
+*           2026/10/16  add bundle_t epoch bundler to raw_t
+*           2026/10/16  add rawevts_t event callbacks to raw_t
+*           2026/10/16  add fingerprints of ephemeris and ion/utc messages
+*           2026/10/16  add ephhist_t ephemeris history by satellite to raw_t
+*           2026/10/16  add ephorb_t orbit constants, satcol_t satellite positions
 *
 *-----------------------------------------------------------------------------*/
 
@@ -214,7 +230,35 @@ extern "C" {
 #define MAXSTRRTK   8                   /* max number of stream in RTK server */
 #define MAXSBSMSG   32                  /* max number of SBAS msg in RTK server */
 #define MAXSOLMSG   8191                /* max length of solution message */
-#define MAXRAWLEN   4096                /* max length of receiver raw message */
+#define MAXRAWLEN   16384               /* max length of receiver raw message */
+#define NINCRAWIDX  65536               /* increment of raw data frame index */
+#define MAXRAWTHRD  256                 /* max number of raw decoding threads */
+#define NMSGTBL     128                 /* size of message decoder table (2^n) */
+#define OBSCOLALIGN 64                  /* alignment of observation columns (bytes) */
+#define NPUBPART    6                   /* number of parts of a published epoch */
+#define PUBNEW      4                   /* flag of a published epoch not read yet */
+#define MAXPAIRBUF  4                   /* max number of epochs held for pairing */
+#define DTPAIR      1.0                 /* default timeout of epoch pairing (s) */
+#define SDVALIDP    0x01                /* single difference valid: pseudorange */
+#define SDVALIDL    0x02                /* single difference valid: carrier-phase */
+#define SDVALIDD    0x04                /* single difference valid: doppler */
+#define SDCOLN      8                   /* stride unit of single difference columns */
+#define NBNDMSG     6                   /* number of message kinds of a bundle */
+#define BNDRANGE    0x01                /* bundle message: RANGE */
+#define BNDRANGEH   0x02                /* bundle message: RANGEH */
+#define BNDPOS      0x04                /* bundle message: gsof position */
+#define BNDVEL      0x08                /* bundle message: gsof velocity */
+#define BNDATT      0x10                /* bundle message: gsof attitude */
+#define BNDSAT      0x20                /* bundle message: gsof satellites */
+#define EVTOBS      0                   /* event: observation data (obs_t) */
+#define EVTEPH      1                   /* event: ephemeris (eph_t) */
+#define EVTION      2                   /* event: ion/utc parameters (evtion_t) */
+#define EVTATT      3                   /* event: gsof attitude (gsof_att_t) */
+#define EVTPOS      4                   /* event: gsof position (gsof_pos_t) */
+#define EVTVEL      5                   /* event: gsof velocity (gsof_vel_t) */
+#define EVTSAT      6                   /* event: gsof satellites (gsof_sat_t) */
+#define NRAWEVT     7                   /* number of event types */
+#define NEPHHIST    8                   /* max number of ephemerides in history of a satellite */
 #define MAXERRMSG   4096                /* max length of error/warning message */
 #define MAXANT      64                  /* max length of station name/antenna type */
 #define MAXSOLBUF   256                 /* max number of solution buffer */
@@ -397,6 +441,9 @@ extern "C" {
 #define MAXRCVFMT    15
 #endif
 
+#define ENDIAN_BE   1                   /* stream byte order: big-endian */
+#define ENDIAN_LE   2                   /* stream byte order: little-endian */
+
 #define STR_MODE_R  0x1                 /* stream mode: read */
 #define STR_MODE_W  0x2                 /* stream mode: write */
 #define STR_MODE_RW 0x3                 /* stream mode: read/write */
@@ -447,6 +494,8 @@ extern "C" {
 #define initlock(f) InitializeCriticalSection(f)
 #define lock(f)     EnterCriticalSection(f)
 #define unlock(f)   LeaveCriticalSection(f)
+#define xchgint(p,v) InterlockedExchange((volatile LONG *)(p),(LONG)(v))
+#define loadint(p)  InterlockedCompareExchange((volatile LONG *)(p),0,0)
 #define FILEPATHSEP '\\'
 #else
 #define thread_t    pthread_t
@@ -454,6 +503,8 @@ extern "C" {
 #define initlock(f) pthread_mutex_init(f,NULL)
 #define lock(f)     pthread_mutex_lock(f)
 #define unlock(f)   pthread_mutex_unlock(f)
+#define xchgint(p,v) __atomic_exchange_n(p,v,__ATOMIC_ACQ_REL)
+#define loadint(p)  __atomic_load_n(p,__ATOMIC_ACQUIRE)
 #define FILEPATHSEP '/'
 #endif
 
@@ -480,6 +531,33 @@ typedef struct {        /* observation data */
     obsd_t *data;       /* observation data records */
 } obs_t;
 
+typedef struct {        /* observation data by columns */
+    gtime_t time;       /* receiver sampling time (GPST) */
+    int n,nmax;         /* number of obervation data/allocated */
+    unsigned char *sat; /* satellite number column */
+    unsigned char *SNR [NFREQ+NEXOBS]; /* signal strength columns (0.25 dBHz) */
+    unsigned char *LLI [NFREQ+NEXOBS]; /* loss of lock indicator columns */
+    unsigned char *code[NFREQ+NEXOBS]; /* code indicator columns (CODE_???) */
+    double *L[NFREQ+NEXOBS]; /* carrier-phase columns (cycle) */
+    double *P[NFREQ+NEXOBS]; /* pseudorange columns (m) */
+    float  *D[NFREQ+NEXOBS]; /* doppler frequency columns (Hz) */
+    void *mem;          /* allocated memory of the columns */
+} obscol_t;
+
+typedef struct {        /* single differences between antennas by columns */
+    gtime_t time;       /* receiver sampling time (GPST) */
+    int n,nmax;         /* number of common satellites/allocated */
+    unsigned char *sat; /* satellite number column */
+    int *im,*ih;        /* record index columns of master/heading antenna */
+    unsigned char *mask[NFREQ+NEXOBS]; /* validity columns (SDVALID???) */
+    double *dL[NFREQ+NEXOBS]; /* carrier-phase columns (master-heading) (cycle) */
+    double *dP[NFREQ+NEXOBS]; /* pseudorange columns (master-heading) (m) */
+    float  *dD[NFREQ+NEXOBS]; /* doppler columns (master-heading) (Hz) */
+    double *hL,*hP;     /* heading carrier-phase/pseudorange columns (work) */
+    float  *hD;         /* heading doppler columns (work) */
+    void *mem;          /* allocated memory of the columns */
+} sdcol_t;
+
 typedef struct {        /* almanac type */
     int sat;            /* satellite number */
     int svh;            /* sv health (0:ok) */
@@ -600,21 +678,174 @@ typedef struct {        /* gsof data type */
     gsof_sat_t  sat;    /* satellite information data */
 } gsof_t;
 
-typedef struct {        /* receiver raw data control type */
+struct raw_tag;
+
+typedef int (*msgfunc_t)(struct raw_tag *raw, const unsigned char *buff,
+                         void *arg);    /* user message decoder */
+
+typedef struct {        /* message decoder table entry type */
+    int id;             /* message id (-1: empty) */
+    int (*le)(struct raw_tag *raw, const unsigned char *buff); /* built-in (LE) */
+    int (*be)(struct raw_tag *raw, const unsigned char *buff); /* built-in (BE) */
+    msgfunc_t func;     /* user decoder (NULL: built-in) */
+    void *arg;          /* argument of user decoder */
+    int sub;            /* subscribed by sub_unicore() (0:no,1:yes) */
+} msgent_t;
+
+typedef struct {        /* message decoder table type */
+    int init;           /* built-in decoders set (0:set at next packet) */
+    int suball;         /* all message ids subscribed (0:no,1:yes) */
+    msgent_t ent[NMSGTBL]; /* entries hashed by message id */
+} msgtbl_t;
+
+typedef struct {        /* receiver raw data config type */
+    int init;           /* parsed from opt (0:parse at next packet) */
+    int endian;         /* stream byte order (ENDIAN_???) */
+    int chkskip;        /* check crc-32 of skipped packets (0:no,1:yes) */
+    int obscol;         /* observation data output (0:raw->obs,1:raw->ocol) */
+    double pairtt;      /* timeout of antenna epoch pairing (s) (0:no pairing) */
+    int sdiff;          /* single differences of pairs (0:no,1:to raw->sd) */
+    int bundle;         /* bundle messages of an epoch (0:no,1:yes) */
+    int ephall;         /* output unchanged ephemerides and ion/utc (0:no,1:yes) */
+} rawcfg_t;
+
+typedef struct {        /* epoch held for antenna pairing type */
+    gtime_t time;       /* observation data time */
+    int n;              /* number of observation data */
+    obsd_t *data;       /* observation data records (MAXOBS allocated) */
+} pairep_t;
+
+typedef struct {        /* dual-antenna epoch pairing type */
+    int n[2];           /* number of held epochs (0:master,1:heading antenna) */
+    pairep_t ep[2][MAXPAIRBUF]; /* held epochs in time order */
+    unsigned int ndrop; /* number of epochs dropped without pair */
+} obspair_t;
+
+typedef struct {        /* epoch bundle type */
+    gtime_t time;       /* epoch time */
+    int week,ms;        /* epoch header week and ms */
+    unsigned int mask;  /* messages in the bundle (BND???) */
+    obs_t obs[2];       /* observation data (0:master,1:heading antenna) */
+    gsof_t gsof;        /* gsof data */
+} bndep_t;
+
+typedef struct {        /* epoch bundler type */
+    bndep_t ep[2];      /* bundles filled by turns */
+    int acc;            /* bundle being filled */
+    int pend;           /* bundle being filled complete, output next (0:no,1:yes) */
+    unsigned int mask;  /* messages in the output bundle (BND???) */
+    unsigned int set;   /* messages expected of the output bundle (BND???) */
+    int tint [NBNDMSG]; /* learned message intervals (ms) (0:unknown) */
+    int tcand[NBNDMSG]; /* candidate message intervals (ms) */
+    int week [NBNDMSG]; /* header week of the last message */
+    int ms   [NBNDMSG]; /* header ms of the last message (-1:none) */
+} bundle_t;
+
+typedef struct {        /* ion/utc parameters of a message type */
+    int sys;            /* navigation system (SYS_GPS,SYS_BDS) */
+    double ion[8];      /* iono model parameters {a0,a1,a2,a3,b0,b1,b2,b3} */
+    double utc[4];      /* delta-UTC parameters {A0,A1,T,W} */
+    int leaps;          /* leap seconds (s) */
+} evtion_t;
+
+typedef struct {        /* decoded message event type */
+    int type;           /* event type (EVT???) */
+    int status;         /* status of the decode functions */
+    int msgid;          /* message id */
+    int ant;            /* antenna of observation data (0:master,1:heading) */
+    gtime_t time;       /* message time (epoch time of observation data) */
+    const void *data;   /* decoded data (type of EVT???) */
+} rawevt_t;
+
+typedef void (*rawevtcb_t)(const rawevt_t *evt, void *arg); /* event callback */
+typedef void (*rawbatchcb_t)(const rawevt_t *evt, int n, void *arg); /* batch callback */
+
+typedef struct {        /* event callbacks type */
+    rawevtcb_t func[NRAWEVT]; /* event callbacks by type (NULL: none) */
+    void *arg[NRAWEVT]; /* arguments of event callbacks */
+    rawbatchcb_t batch; /* batch callback (NULL: none) */
+    void *barg;         /* argument of batch callback */
+    int n,nmax;         /* number of batched events/allocated */
+    rawevt_t *evt;      /* batched events (data set when the batch is passed) */
+    size_t *off;        /* offsets of the data of batched events (bytes) */
+    size_t ndata,ndmax; /* size of batched event data/allocated (bytes) */
+    unsigned char *data; /* batched event data */
+} rawevts_t;
+
+typedef struct {        /* orbit constants of an ephemeris type */
+    int type;           /* orbit type (0:invalid,1:MEO/IGSO,2:BDS GEO) */
+    double n;           /* corrected mean motion (rad/s) */
+    double sqe;         /* sqrt(1-e^2) */
+    double sinw,cosw;   /* sin/cos of argument of perigee */
+    double sini,cosi;   /* sin/cos of inclination angle at toe */
+    double OMG0;        /* OMG0-omge*toes, node in ecef at toe (rad) */
+    double OMGd;        /* rate of the node in ecef (BDS GEO: inertial) (rad/s) */
+    double omge;        /* earth angular velocity (rad/s) */
+    double frel;        /* relativity: -2*sqrt(mu*A)*e/c^2 (s) */
+} ephorb_t;
+
+typedef struct {        /* ephemeris history of a satellite type */
+    int n;              /* number of ephemerides */
+    unsigned char slot[NEPHHIST]; /* slots of the ephemerides in toe order */
+    double toe[NEPHHIST]; /* toe of the ephemerides in toe order (s) */
+    unsigned int ver[NEPHHIST]; /* versions of the ephemerides by slot */
+    ephorb_t orb[NEPHHIST]; /* orbit constants of the ephemerides by slot */
+    eph_t eph[NEPHHIST]; /* ephemerides by slot */
+} ephsat_t;
+
+typedef struct {        /* ephemeris history type */
+    unsigned int ver;   /* version of the last update */
+    ephsat_t *sat;      /* histories of satellites (MAXSAT allocated) */
+} ephhist_t;
+
+typedef struct {        /* satellite positions and clocks by columns type */
+    gtime_t time;       /* time of the positions (gpst) */
+    int n,nmax;         /* number of satellites/allocated */
+    unsigned char *sat; /* satellite number column */
+    int *svh;           /* sv health column */
+    double *x,*y,*z;    /* satellite position columns (ecef) (m) */
+    double *dts;        /* satellite clock bias columns (s) */
+    double *tgd;        /* group delay columns (GPS: TGD, BDS: TGD1) (s) */
+    double *az,*el;     /* azimuth/elevation angle columns (rad) */
+    void *mem;          /* allocated memory of the columns */
+} satcol_t;
+
+typedef struct {        /* satellite to obs row map type */
+    unsigned int gen;   /* generation of the current epoch */
+    unsigned int sgen[MAXSAT+1]; /* generation of the satellite row */
+    int row[MAXSAT+1];  /* obs row of the satellite (valid if sgen==gen) */
+} satrow_t;
+
+typedef struct raw_tag { /* receiver raw data control type */
     gtime_t time;       /* message time */
     gtime_t tobs;       /* observation data time */
     obs_t obs;          /* observation data */
-    obs_t obuf;         /* observation data buffer */
+    obs_t obuf;         /* observation data buffer (heading antenna of pair) */
+    obscol_t ocol;      /* observation data by columns (-OBSCOL) */
+    obspair_t pair;     /* epochs held for antenna pairing (-PAIR) */
+    sdcol_t sd;         /* single differences of the pair (-SDIFF) */
+    bundle_t bnd;       /* epoch bundler (-BUNDLE) */
+    satrow_t satrow;    /* satellite to obs row map of the epoch */
     nav_t nav;          /* satellite ephemerides */
     int ephsat;         /* sat number of update ephemeris (0:no satellite) */
+    unsigned int ephcrc[MAXSAT]; /* fingerprints of ephemeris messages (0:none) */
+    unsigned int ioncrc[2]; /* fingerprints of ion/utc messages (0:gps,1:bds) */
+    ephhist_t ehist;    /* ephemeris history by satellite */
     gsof_t  gsof;       /* gsof data */
     char msgtype[256];  /* last message type */
     int nbyte;          /* number of bytes in message buffer */ 
     int len;            /* message length (bytes) */
+    unsigned int crc;   /* crc-32 of stored message bytes */
+    int skip;           /* skip message bytes without store (0:store,1:skip) */
+    int iscan;          /* offset of bytes to rescan in message buffer */
+    int nscan;          /* number of bytes to rescan in message buffer */
     int tbase;          /* time base (0:gpst,1:utc(usno),2:glonass,3:utc(su),4:bdst */
     int outtype;        /* output message type flag */
     unsigned char buff[MAXRAWLEN]; /* message buffer */
     char opt[256];      /* receiver dependent options */
+    rawcfg_t cfg;       /* options parsed by setopt_raw() */
+    msgtbl_t msgtbl;    /* message decoder table */
+    rawevts_t evts;     /* event callbacks (on_unicore()) */
     double receive_time;/* RT17: Reiceve time of week for week rollover detection */
     unsigned int plen;  /* RT17: Total size of packet to be read */
     unsigned int pbyte; /* RT17: How many packet bytes have been read so far */
@@ -622,17 +853,108 @@ typedef struct {        /* receiver raw data control type */
     unsigned int reply; /* RT17: Current reply number */
     int week;           /* RT17 & unicoreHeader: week number */
     double seconds;     /* unicoreHeader: seconds in gps week */
+    int msgid;          /* unicoreHeader: message id */
     unsigned char antno;/* antenna number for multi-antenna receiver */
     unsigned char pbuff[255+4+2]; /* RT17: Packet buffer */
 } raw_t;
 
+typedef struct {        /* memory-mapped raw data file type */
+    const unsigned char *data; /* mapped file data (NULL: empty file) */
+    long long size;     /* file size (bytes) */
+    long long pos;      /* current decoding position (bytes) */
+#ifdef WIN32
+    HANDLE file;        /* file handle */
+    HANDLE map;         /* file mapping handle */
+#else
+    int fd;             /* file descriptor */
+#endif
+} rawfile_t;
+
+typedef struct {        /* raw data frame index record type */
+    long long offset;   /* file offset of frame head (bytes) */
+    int len;            /* frame length (bytes) */
+    unsigned short msgid; /* message id */
+    unsigned short week;  /* gps week of header time tag */
+    unsigned int ms;    /* milliseconds in week of header time tag */
+} rawidx_t;
+
+typedef struct {        /* raw data frame index type */
+    int n,nmax;         /* number of frames/allocated */
+    long long size;     /* size of indexed file (bytes) */
+    rawidx_t *data;     /* frame records in file order */
+} rawindex_t;
+
+typedef struct {        /* published epoch type */
+    unsigned int seq;   /* publication sequence number (1,2,...) */
+    int status;         /* status of the last published message */
+    gtime_t time;       /* time of the last published message */
+    gtime_t tobs[2];    /* observation data time (0:master,1:heading antenna) */
+    int nobs[2];        /* number of observation data */
+    obsd_t obs[2][MAXOBS]; /* observation data (0:master,1:heading antenna) */
+    gsof_t gsof;        /* gsof data */
+    unsigned int ver[NPUBPART]; /* versions of the parts of the epoch */
+} rawepoch_t;
+
+typedef struct {        /* triple buffer of published epochs type */
+    rawepoch_t buf[3];  /* epoch buffers */
+    rawepoch_t cur;     /* current epoch of the writer */
+    unsigned int ver;   /* last part version of the writer */
+    int back;           /* buffer of the writer */
+    int front;          /* buffer of the reader */
+    int mid;            /* buffer exchanged (+PUBNEW: not read yet) */
+} rawpub_t;
+
+typedef int (*rawcb_t)(raw_t *raw, int status, void *arg); /* message callback */
+
 /* external call functions ---------------------------------------------------*/
 
 extern int init_raw   (raw_t *raw);
 extern void free_raw  (raw_t *raw);
+extern void setopt_raw(raw_t *raw, const char *opt);
+extern int  init_obscol(obscol_t *col, int nmax);
+extern void free_obscol(obscol_t *col);
+extern int  obs2obscol (const obs_t *obs, obscol_t *col);
+extern int  obscol2obs (const obscol_t *col, obs_t *obs);
+extern int  init_sdcol (sdcol_t *sd, int nmax);
+extern void free_sdcol (sdcol_t *sd);
+extern int  sdiff_obs  (const obs_t *obs, const obs_t *obsh, sdcol_t *sd);
+extern void init_rawpub(rawpub_t *pub);
+extern int  pub_raw    (rawpub_t *pub, const raw_t *raw, int status);
+extern const rawepoch_t *read_rawpub(rawpub_t *pub);
+extern int  open_rawfile (rawfile_t *file, const char *path);
+extern void close_rawfile(rawfile_t *file);
+extern int  add_rawindex (rawindex_t *index, const rawidx_t *rec);
+extern void free_rawindex(rawindex_t *index);
+extern int  read_rawindex (const char *path, rawindex_t *index);
+extern int  write_rawindex(const char *path, const rawindex_t *index);
+extern int  search_rawindex(const rawindex_t *index, gtime_t time);
+extern int  init_ephhist(ephhist_t *hist);
+extern void free_ephhist(ephhist_t *hist);
+extern int  add_ephhist (ephhist_t *hist, const eph_t *eph);
+extern const eph_t *select_eph(const ephhist_t *hist, int sat, gtime_t time,
+                               int iode);
+extern int  init_satcol(satcol_t *sc, int nmax);
+extern void free_satcol(satcol_t *sc);
+extern int  satpos_col (const ephhist_t *hist, gtime_t time, const int *sat,
+                        int n, satcol_t *sc);
+extern void satazel_col(satcol_t *sc, const double *rr);
 
 extern int decode_unicore (raw_t *raw, unsigned char data);
+extern int decode_unicore_buf(raw_t *raw, const unsigned char *buff, size_t n,
+                              size_t *consumed);
 extern int decode_unicoref (raw_t *raw, FILE *fp);
+extern int decode_unicorem (raw_t *raw, rawfile_t *file);
+extern int index_unicore   (raw_t *raw, const rawfile_t *file, rawindex_t *index);
+extern int decode_unicore_at(raw_t *raw, rawfile_t *file, const rawidx_t *rec);
+extern int decode_unicorep (raw_t *raw, rawfile_t *file, int nthread, rawcb_t cb,
+                            void *arg);
+extern int decode_unicore_evt(raw_t *raw, const unsigned char *buff, size_t n);
+extern int reg_unicore  (raw_t *raw, int msgid, msgfunc_t func, void *arg);
+extern int unreg_unicore(raw_t *raw, int msgid);
+extern int sub_unicore  (raw_t *raw, const int *msgid, int n);
+extern int gen_unicore  (raw_t *raw, int msgid, unsigned char *buff);
+extern int on_unicore   (raw_t *raw, int type, rawevtcb_t func, void *arg);
+extern void onbatch_unicore(raw_t *raw, rawbatchcb_t func, void *arg);
 
 
 /* public functions for decoding ---------------------------------------------*/
@@ -641,6 +963,12 @@ extern int decode_unicoref (raw_t *raw, FILE *fp);
 extern void trace    (int level, const char *format, ...);
 /* receiver raw data functions */
 extern unsigned int crc32  (const unsigned char *buff, int len);
+extern unsigned int crc32_s8    (unsigned int crc, const unsigned char *buff, int len);
+extern unsigned int crc32_s16   (unsigned int crc, const unsigned char *buff, int len);
+extern unsigned int crc32_pclmul(unsigned int crc, const unsigned char *buff, int len);
+extern unsigned int crc32_update(unsigned int crc, const unsigned char *buff, int len);
+extern const char  *crc32_engine(void);
+extern int cpu_avx2(void);
 /* satellites, systems, codes functions */
 extern int  satno   (int sys, int prn);
 extern int  satsys  (int sat, int *prn);
@@ -657,6 +985,9 @@ extern gtime_t timeadd  (gtime_t t, double sec);
 extern double  timediff (gtime_t t1, gtime_t t2);
 extern gtime_t gpst2utc (gtime_t t);
 extern gtime_t utc2gpst (gtime_t t);
+/* coordinates transformation */
+extern void ecef2pos(const double *r, double *pos);
+extern void pos2ecef(const double *pos, double *r);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,237 @@
+/*------------------------------------------------------------------------------
+* decode.hpp: C++ interface of the unicore decoder
+*
+* author  : Guangli Dong
+*
+* history : 2026/10/16  new
+*           2026/10/16  add RangeColumns of observation data by columns
+*           2026/10/16  add RangePair of paired antenna epochs
+*           2026/10/16  add single differences to RangePair
+*           2026/10/16  add Bundle of the messages of an epoch
+*
+* notes   : header only, C++17 or later. the decoder owns a raw_t released
+*           on destruction. input is a span of bytes, std::span in C++20.
+*           decoded messages are passed to the on() member of a visitor by
+*           their type, resolved at compile time:
+*
+*             struct printer {
+*                 void on(const unicore::RangeEpoch &m) {...}
+*                 void on(const unicore::Attitude &m) {...}
+*             };
+*             unicore::Decoder dec("-LE");
+*             dec.decode(bytes, printer{});
+*
+*           messages without an on() overload in the visitor are skipped.
+*           the messages are views of the data in the raw_t, valid in the
+*           on() call only. nothing is allocated after the construction.
+*-----------------------------------------------------------------------------*/
+
+#ifndef DECODE_HPP
+#define DECODE_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#endif
+#endif
+
+#include "decode.h"
+
+namespace unicore {
+
+/* input bytes ---------------------------------------------------------------*/
+#if defined(__cpp_lib_span)
+using bytes = std::span<const std::byte>;
+#else
+class bytes {           /* view of contiguous bytes (std::span in C++20) */
+public:
+    constexpr bytes() noexcept : data_(nullptr), size_(0) {}
+    constexpr bytes(const std::byte *data, std::size_t size) noexcept
+        : data_(data), size_(size) {}
+    constexpr const std::byte *data() const noexcept {return data_;}
+    constexpr std::size_t size() const noexcept {return size_;}
+    constexpr bool empty() const noexcept {return size_ == 0;}
+    constexpr bytes subspan(std::size_t off) const noexcept {
+        return bytes(data_+off, size_-off);
+    }
+private:
+    const std::byte *data_;
+    std::size_t size_;
+};
+#endif
+
+/* decoded messages ----------------------------------------------------------*/
+struct RangeEpoch {     /* observations of an epoch (status 1, 11) */
+    gtime_t time;       /* observation time */
+    const obsd_t *data; /* observation records */
+    int n;              /* number of observation records */
+    int antenna;        /* antenna (0:master,1:heading) */
+    const obsd_t *begin() const noexcept {return data;}
+    const obsd_t *end() const noexcept {return data+n;}
+};
+struct RangeColumns {   /* observations of an epoch by columns (status 1, 11
+                           with -OBSCOL) */
+    const obscol_t &col;
+    int antenna;        /* antenna (0:master,1:heading) */
+};
+struct RangePair {      /* observations of both antennas at an epoch (status 12
+                           with -PAIR) */
+    RangeEpoch master;  /* master antenna */
+    RangeEpoch heading; /* heading antenna */
+    const sdcol_t *sd;  /* single differences (-SDIFF, else nullptr) */
+};
+struct Bundle {         /* messages of an epoch (status 31 with -BUNDLE) */
+    gtime_t time;       /* epoch time */
+    unsigned int mask;  /* messages in the bundle (BND???) */
+    unsigned int set;   /* messages expected at the epoch (BND???) */
+    RangeEpoch master;  /* master antenna (BNDRANGE) */
+    RangeEpoch heading; /* heading antenna (BNDRANGEH) */
+    const gsof_t &gsof; /* gsof data (BNDPOS, BNDVEL, BNDATT, BNDSAT) */
+    bool complete() const noexcept {return set && (mask & set) == set;}
+};
+struct Ephemeris {      /* ephemeris of a satellite (status 2) */
+    const eph_t &eph;
+};
+struct IonUtc {         /* ion/utc parameters of the system of msgid (status 9) */
+    const nav_t &nav;
+    int msgid;          /* message id */
+};
+struct Position {       /* gsof position (status 21) */
+    const gsof_pos_t &pos;
+};
+struct Velocity {       /* gsof velocity (status 22) */
+    const gsof_vel_t &vel;
+};
+struct Attitude {       /* gsof attitude (status 23) */
+    const gsof_att_t &att;
+};
+struct SatVis {         /* gsof satellites in vision (status 24) */
+    const gsof_sat_t &sat;
+};
+struct Status {         /* other status (-1: error, user decoder returns) */
+    int status;         /* status of the decode functions */
+    int msgid;          /* message id */
+};
+
+namespace detail {
+template <class V, class M, class = void>
+struct has_on : std::false_type {};
+template <class V, class M>
+struct has_on<V, M, std::void_t<decltype(
+    std::declval<V&>().on(std::declval<const M&>()))>> : std::true_type {};
+
+/* pass a message to the visitor if it takes the message type */
+template <class V, class M>
+inline void visit(V &vis, const M &msg)
+{
+    if constexpr (has_on<V, M>::value) vis.on(msg);
+}
+
+struct raw_delete {
+    void operator()(raw_t *raw) const noexcept {free_raw(raw); std::free(raw);}
+};
+} /* namespace detail */
+
+/* decoder -------------------------------------------------------------------*/
+class Decoder {
+public:
+    /* construct with receiver dependent options (see setopt_raw()) */
+    explicit Decoder(const char *opt = "")
+        : raw_(static_cast<raw_t *>(std::malloc(sizeof(raw_t))))
+    {
+        if (!raw_) throw std::bad_alloc();
+        if (!init_raw(raw_.get())) {
+            std::free(raw_.release());
+            throw std::bad_alloc();
+        }
+        setopt_raw(raw_.get(), opt);
+    }
+    Decoder(Decoder &&) noexcept = default;
+    Decoder &operator=(Decoder &&) noexcept = default;
+
+    /* decode bytes of the stream and pass the messages to the visitor,
+     * returns the number of messages */
+    template <class V>
+    int decode(bytes in, V &&vis)
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(in.data());
+        std::size_t n = in.size(), used;
+        int status, nmsg = 0;
+
+        while (n > 0) {
+            status = decode_unicore_buf(raw_.get(), p, n, &used);
+            p += used;
+            n -= used;
+            if (status) {dispatch(status, vis); nmsg++;}
+        }
+        return nmsg;
+    }
+    /* decode the bytes held back at the end of the stream, returns the
+     * number of messages */
+    template <class V>
+    int flush(V &&vis)
+    {
+        int status, nmsg = 0;
+
+        while ((raw_->nscan > 0 || raw_->bnd.pend) &&
+               (status = decode_unicore_buf(raw_.get(), NULL, 0, NULL))) {
+            dispatch(status, vis);
+            nmsg++;
+        }
+        return nmsg;
+    }
+    /* pass the message of a status of the decode functions to the visitor */
+    template <class V>
+    void dispatch(int status, V &vis) const
+    {
+        const raw_t &r = *raw_;
+
+        switch (status) {
+            case 1:
+            case 11:
+                if (r.cfg.obscol) detail::visit(vis, RangeColumns{r.ocol, r.antno});
+                else detail::visit(vis, RangeEpoch{r.time, r.obs.data, r.obs.n,
+                                                   r.antno});
+                break;
+            case 12:
+                detail::visit(vis, RangePair{RangeEpoch{r.tobs, r.obs.data, r.obs.n, 0},
+                                             RangeEpoch{r.tobs, r.obuf.data, r.obuf.n, 1},
+                                             r.cfg.sdiff ? &r.sd : nullptr});
+                break;
+            case 31:
+                detail::visit(vis, Bundle{r.tobs, r.bnd.mask, r.bnd.set,
+                                          RangeEpoch{r.tobs, r.obs.data, r.obs.n, 0},
+                                          RangeEpoch{r.tobs, r.obuf.data, r.obuf.n, 1},
+                                          r.gsof});
+                break;
+            case 2:  detail::visit(vis, Ephemeris{r.nav.eph[r.ephsat-1]}); break;
+            case 9:  detail::visit(vis, IonUtc{r.nav, r.msgid}); break;
+            case 21: detail::visit(vis, Position{r.gsof.pos}); break;
+            case 22: detail::visit(vis, Velocity{r.gsof.vel}); break;
+            case 23: detail::visit(vis, Attitude{r.gsof.att}); break;
+            case 24: detail::visit(vis, SatVis{r.gsof.sat}); break;
+            default: detail::visit(vis, Status{status, r.msgid}); break;
+        }
+    }
+    /* subscribe message ids (empty: all ids), see sub_unicore() */
+    bool subscribe(const int *msgid, int n) {return sub_unicore(raw_.get(), msgid, n);}
+    template <std::size_t N>
+    bool subscribe(const int (&msgid)[N]) {return subscribe(msgid, static_cast<int>(N));}
+
+    /* receiver raw data control of the C decoders */
+    raw_t *raw() noexcept {return raw_.get();}
+    const raw_t *raw() const noexcept {return raw_.get();}
+
+private:
+    std::unique_ptr<raw_t, detail::raw_delete> raw_;
+};
+
+} /* namespace unicore */
+
+#endif /* DECODE_HPP */
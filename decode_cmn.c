@@ -4,14 +4,73 @@
 * author       : Guangli Dong
 *
 * history      : 2016/04/14 created
+*                2026/10/16 add table-driven and pclmulqdq crc-32 engines
+*                2026/10/16 add memory-mapped raw data file functions
+*                2026/10/16 add raw data frame index functions
+*                2026/10/16 add observation data by columns functions
+*                2026/10/16 add triple buffer of published epochs functions
+*                2026/10/16 add -PAIR option of dual-antenna epoch pairing
+*                2026/10/16 add between-antenna single difference functions
+*                2026/10/16 add -BUNDLE option of epoch bundler
+*                2026/10/16 add event callbacks to raw data control
+*                2026/10/16 add -EPHALL option of unchanged ephemeris output
+*                2026/10/16 add ephemeris history functions
+*                2026/10/16 add batched satellite position functions
+*                2026/10/16 add cpu_avx2 function for run time kernel selection
 *
 * ----------------------------------------------------------------------------*/
 
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64            /* 64-bit off_t for files over 2 GB */
+#endif
+
 #include "decode.h"
 
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define CRC32_PCLMUL                    /* pclmulqdq crc-32 engine available */
+#define SDIFF_AVX2                      /* avx2 single difference kernel */
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32_TARGET
+#define AVX2_TARGET
+#else
+#define CRC32_TARGET __attribute__((target("pclmul,sse4.1")))
+#define AVX2_TARGET  __attribute__((target("avx2")))
+#endif
+#endif
+
 /* constants -----------------------------------------------------------------*/
 #define POLYCRC32   0xEDB88320u /* CRC32 polynomial */
 
+#define IDXMAGIC    "UCIDX"     /* raw data frame index file magic */
+#define IDXVER      1           /* raw data frame index file version */
+#define IDXHLEN     24          /* raw data frame index file header length */
+#define IDXRLEN     20          /* raw data frame index record length */
+#define WEEKMS      604800000LL /* milliseconds in a week */
+
+#define MU_GPS      3.9860050E14     /* gravitational constant (IS-GPS) */
+#define MU_BDS      3.986004418E14   /* earth gravitational constant (BDS ICD) */
+#define OMGE_BDS    7.292115E-5      /* earth angular velocity (BDS ICD) (rad/s) */
+#define SIN_5       -0.0871557427476582 /* sin(-5.0 deg) */
+#define COS_5       0.9961946980917456  /* cos(-5.0 deg) */
+#define RTOL_KEPLER 1E-13       /* relative tolerance for Kepler equation */
+#define MAX_ITER_KEPLER 30      /* max number of iteration of Kepler */
+#define NKEPLER     3           /* Kepler iterations of all satellites of a block */
+#define SATBLK      32          /* satellites of a block of batched positions */
+
+typedef unsigned int (*crc32_func_t)(unsigned int crc, const unsigned char *buff,
+                                     int len);
+
 const static double gpst0[]={1980,1, 6,0,0,0}; /* gps time reference */
 const static double gst0 []={1999,8,22,0,0,0}; /* galileo system time reference */
 const static double bdt0 []={2006,1, 1,0,0,0}; /* beidou time reference */
@@ -78,19 +137,39 @@ extern int init_raw(raw_t *raw)
 
     trace(3,"init_raw:\n");
 
+    /* Select crc-32 engine before any stream is decoded */
+    crc32_engine();
+
     /* Init time */
     raw->time   = raw->tobs = time0;
     raw->week=0;
     raw->seconds=0;
+    raw->msgid=0;
 
     /* Init ephemeris update flag */
     raw->ephsat = 0;
+    memset(raw->ephcrc, 0, sizeof(raw->ephcrc));
+    memset(raw->ioncrc, 0, sizeof(raw->ioncrc));
 
     /* Init antenna indicator for multi-antennas receiver */
     raw->antno  = 0;
 
-    /* Init raw data control option */
+    /* Init raw data control option, parsed at the first packet */
     raw->opt[0]='\0';
+    raw->cfg.init=0;
+    raw->cfg.endian=ENDIAN_BE;
+    raw->cfg.chkskip=1;
+    raw->cfg.obscol=0;
+    raw->cfg.pairtt=0.0;
+    raw->cfg.sdiff=0;
+    raw->cfg.bundle=0;
+    raw->cfg.ephall=0;
+
+    /* Init message decoder table, built-in decoders set at the first packet */
+    raw->msgtbl.init=0;
+
+    /* Init event callbacks */
+    memset(&raw->evts, 0, sizeof(rawevts_t));
 
     /* Init message tpye value and control option */
     raw->msgtype[0]='\0';
@@ -98,6 +177,9 @@ extern int init_raw(raw_t *raw)
 
     /* Init message buffer */
     raw->nbyte=raw->len=0;
+    raw->crc=0;
+    raw->skip=0;
+    raw->iscan=raw->nscan=0;
     memset(raw->buff, 0x00, MAXRAWLEN);
 
     /* Init packet buffer for RT17 */    
@@ -108,6 +190,12 @@ extern int init_raw(raw_t *raw)
     /* Clear data pointers */
     raw->obs.data =NULL;
     raw->obuf.data = NULL;
+    raw->ocol.mem = NULL;
+    raw->sd.mem = NULL;
+    raw->ehist.sat = NULL;
+    memset(&raw->bnd, 0, sizeof(bundle_t));
+    for (i=0; i<NBNDMSG; i++) raw->bnd.ms[i] = -1;
+    memset(&raw->pair, 0, sizeof(obspair_t));
     raw->nav.eph =NULL;
     raw->nav.geph = NULL;
     raw->nav.alm =NULL;
@@ -117,14 +205,37 @@ extern int init_raw(raw_t *raw)
         !(raw->obuf.data= (obsd_t   *)malloc(sizeof(obsd_t)*MAXOBS))||
         !(raw->nav.eph  = (eph_t    *)malloc(sizeof(eph_t )*MAXSAT))||
         !(raw->nav.alm  = (alm_t    *)malloc(sizeof(alm_t )*MAXSAT))||
-        !(raw->nav.geph = (geph_t   *)malloc(sizeof(geph_t)*NSATGLO))) {
+        !(raw->nav.geph = (geph_t   *)malloc(sizeof(geph_t)*NSATGLO))||
+        !init_obscol(&raw->ocol,MAXOBS)||
+        !init_sdcol(&raw->sd,MAXOBS)||
+        !init_ephhist(&raw->ehist)) {
             free_raw(raw);
             return 0;
     }
+    for (i=0; i<2*MAXPAIRBUF; i++) {
+        if (!(raw->pair.ep[i/MAXPAIRBUF][i%MAXPAIRBUF].data=
+              (obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) {
+            free_raw(raw);
+            return 0;
+        }
+        for (j=0; j<MAXOBS; j++) raw->pair.ep[i/MAXPAIRBUF][i%MAXPAIRBUF].data[j] = data0;
+    }
+    for (i=0; i<4; i++) {
+        if (!(raw->bnd.ep[i/2].obs[i%2].data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) {
+            free_raw(raw);
+            return 0;
+        }
+        for (j=0; j<MAXOBS; j++) raw->bnd.ep[i/2].obs[i%2].data[j] = data0;
+        raw->bnd.ep[i/2].obs[i%2].nmax = MAXOBS;
+    }
 
     /* Reset data numbers */
     raw->obs.n  = 0;
+    raw->obs.nmax = MAXOBS;
+    raw->satrow.gen = 0;
+    memset(raw->satrow.sgen, 0, sizeof(raw->satrow.sgen));
     raw->obuf.n = 0;
+    raw->obuf.nmax = MAXOBS;
     raw->nav.n=raw->nav.na = MAXSAT;
     raw->nav.ng = NSATGLO;
 //    raw->nav.nb=raw->nav.nba = MAXSAT;
@@ -156,6 +267,8 @@ extern int init_raw(raw_t *raw)
 *-----------------------------------------------------------------------------*/
 extern void free_raw(raw_t *raw)
 {
+    int i;
+
     trace(3,"free_raw:\n");
 
     free(raw->obs.data  );  raw->obs.data   = NULL; raw->obs.n  = 0;
@@ -163,8 +276,1189 @@ extern void free_raw(raw_t *raw)
     free(raw->nav.eph   );  raw->nav.eph    = NULL; raw->nav.n  = 0;
     free(raw->nav.geph  );  raw->nav.geph   = NULL; raw->nav.ng = 0;
     free(raw->nav.alm   );  raw->nav.alm    = NULL; raw->nav.na = 0;
+    free_obscol(&raw->ocol);
+    free_sdcol(&raw->sd);
+    free_ephhist(&raw->ehist);
+    free(raw->evts.evt ); raw->evts.evt =NULL; raw->evts.n=raw->evts.nmax=0;
+    free(raw->evts.off ); raw->evts.off =NULL;
+    free(raw->evts.data); raw->evts.data=NULL; raw->evts.ndata=raw->evts.ndmax=0;
+    for (i=0;i<2*MAXPAIRBUF;i++) {
+        free(raw->pair.ep[i/MAXPAIRBUF][i%MAXPAIRBUF].data);
+        raw->pair.ep[i/MAXPAIRBUF][i%MAXPAIRBUF].data=NULL;
+    }
+    raw->pair.n[0]=raw->pair.n[1]=0;
+    for (i=0;i<4;i++) {
+        free(raw->bnd.ep[i/2].obs[i%2].data);
+        raw->bnd.ep[i/2].obs[i%2].data=NULL;
+        raw->bnd.ep[i/2].obs[i%2].n=0;
+    }
 }
 
+/* set receiver raw data options ----------------------------------------------
+* set receiver dependent options and parse them into raw->cfg
+* args   : raw_t  *raw   IO     receiver raw data control struct
+*          char   *opt   I      receiver dependent options
+*                                 -LE : little-endian stream (default: big)
+*                                 -FASTSKIP : skip packets by message id
+*                                             without crc-32 check
+*                                             (default: checked)
+*                                 -OBSCOL : output observation data by columns
+*                                           to raw->ocol (default: raw->obs)
+*                                 -PAIR[=tt] : pair the epochs of the master
+*                                              and heading antenna, held
+*                                              epochs time out after tt s
+*                                              (default: no pairing, tt=DTPAIR)
+*                                 -SDIFF : single differences of the pairs of
+*                                          -PAIR to raw->sd (default: no)
+*                                 -BUNDLE : bundle the observation and gsof
+*                                           messages of an epoch (default: no)
+*                                 -EPHALL : output ephemerides and ion/utc
+*                                           parameters also unchanged
+*                                           (default: changed only)
+* return : none
+* notes  : options are parsed once here instead of for every packet. if
+*          raw->opt is written directly, it is parsed at the next packet
+*          head, later direct changes need a call of setopt_raw(raw,raw->opt)
+*-----------------------------------------------------------------------------*/
+extern void setopt_raw(raw_t *raw, const char *opt)
+{
+    const char *p;
+
+    trace(3,"setopt_raw: opt=%s\n",opt);
+
+    if (opt!=raw->opt) {
+        strncpy(raw->opt,opt,sizeof(raw->opt)-1);
+        raw->opt[sizeof(raw->opt)-1]='\0';
+    }
+    raw->cfg.endian=strstr(raw->opt,"-LE")?ENDIAN_LE:ENDIAN_BE;
+    raw->cfg.chkskip=strstr(raw->opt,"-FASTSKIP")?0:1;
+    raw->cfg.obscol=strstr(raw->opt,"-OBSCOL")?1:0;
+    raw->cfg.pairtt=0.0;
+    if ((p=strstr(raw->opt,"-PAIR"))) {
+        if (sscanf(p,"-PAIR=%lf",&raw->cfg.pairtt)<1||raw->cfg.pairtt<=0.0) {
+            raw->cfg.pairtt=DTPAIR;
+        }
+    }
+    raw->cfg.sdiff=strstr(raw->opt,"-SDIFF")?1:0;
+    raw->cfg.bundle=strstr(raw->opt,"-BUNDLE")?1:0;
+    raw->cfg.ephall=strstr(raw->opt,"-EPHALL")?1:0;
+    raw->cfg.init=1;
+}
+/* initialize observation data by columns ------------------------------------
+* allocate the columns of observation data by columns
+* args   : obscol_t *col    O   observation data by columns
+*          int    nmax      I   max number of observation data
+* return : status (1:ok,0:memory allocation error)
+* notes  : the columns are cleared and aligned to OBSCOLALIGN bytes in one
+*          memory block, so a loop over a column of all satellites reads
+*          contiguous and aligned memory.
+*-----------------------------------------------------------------------------*/
+extern int init_obscol(obscol_t *col, int nmax)
+{
+    unsigned char *p;
+    size_t n1,n4,n8;
+    int i;
+
+    trace(3,"init_obscol: nmax=%d\n",nmax);
+
+    /* column sizes rounded up to the alignment */
+    n1=((size_t)nmax  +OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+    n4=((size_t)nmax*4+OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+    n8=((size_t)nmax*8+OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+
+    col->n=col->nmax=0;
+    col->time.time=0; col->time.sec=0.0;
+    if (!(col->mem=calloc(n1*(1+3*(NFREQ+NEXOBS))+(n4+2*n8)*(NFREQ+NEXOBS)+
+                          OBSCOLALIGN,1))) {
+        return 0;
+    }
+    p=(unsigned char *)col->mem;
+    p+=(OBSCOLALIGN-(size_t)p%OBSCOLALIGN)%OBSCOLALIGN;
+
+    col->sat=p; p+=n1;
+    for (i=0;i<NFREQ+NEXOBS;i++) {
+        col->L   [i]=(double *)p; p+=n8;
+        col->P   [i]=(double *)p; p+=n8;
+        col->D   [i]=(float  *)p; p+=n4;
+        col->SNR [i]=p; p+=n1;
+        col->LLI [i]=p; p+=n1;
+        col->code[i]=p; p+=n1;
+    }
+    col->nmax=nmax;
+    return 1;
+}
+/* free observation data by columns --------------------------------------------
+* free the columns of observation data by columns
+* args   : obscol_t *col    IO  observation data by columns
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void free_obscol(obscol_t *col)
+{
+    trace(3,"free_obscol:\n");
+
+    free(col->mem); col->mem=NULL; col->n=col->nmax=0;
+}
+/* observation data to observation data by columns -----------------------------
+* convert observation data records to observation data by columns
+* args   : obs_t  *obs      I   observation data
+*          obscol_t *col    IO  observation data by columns
+* return : number of observation data converted
+* notes  : the time of the first record is taken as the epoch time. records
+*          over col->nmax are dropped.
+*-----------------------------------------------------------------------------*/
+extern int obs2obscol(const obs_t *obs, obscol_t *col)
+{
+    const obsd_t *d;
+    int i,j;
+
+    col->n=obs->n<col->nmax?obs->n:col->nmax;
+    if (col->n>0) col->time=obs->data[0].time;
+
+    for (i=0;i<col->n;i++) {
+        d=obs->data+i;
+        col->sat[i]=d->sat;
+        for (j=0;j<NFREQ+NEXOBS;j++) {
+            col->L   [j][i]=d->L   [j];
+            col->P   [j][i]=d->P   [j];
+            col->D   [j][i]=d->D   [j];
+            col->SNR [j][i]=d->SNR [j];
+            col->LLI [j][i]=d->LLI [j];
+            col->code[j][i]=d->code[j];
+        }
+    }
+    return col->n;
+}
+/* observation data by columns to observation data -----------------------------
+* convert observation data by columns to observation data records
+* args   : obscol_t *col    I   observation data by columns
+*          obs_t  *obs      IO  observation data (obs->nmax records allocated)
+* return : number of observation data converted
+* notes  : all records get the epoch time and receiver number 0. records over
+*          obs->nmax are dropped.
+*-----------------------------------------------------------------------------*/
+extern int obscol2obs(const obscol_t *col, obs_t *obs)
+{
+    obsd_t *d;
+    int i,j;
+
+    obs->n=col->n<obs->nmax?col->n:obs->nmax;
+
+    for (i=0;i<obs->n;i++) {
+        d=obs->data+i;
+        d->time=col->time;
+        d->sat=col->sat[i];
+        d->rcv=0;
+        for (j=0;j<NFREQ+NEXOBS;j++) {
+            d->L   [j]=col->L   [j][i];
+            d->P   [j]=col->P   [j][i];
+            d->D   [j]=col->D   [j][i];
+            d->SNR [j]=col->SNR [j][i];
+            d->LLI [j]=col->LLI [j][i];
+            d->code[j]=col->code[j][i];
+        }
+    }
+    return obs->n;
+}
+/* initialize single differences by columns ----------------------------------
+* allocate the columns of single differences between antennas
+* args   : sdcol_t *sd      O   single differences by columns
+*          int    nmax      I   max number of common satellites
+* return : status (1:ok,0:memory allocation error)
+* notes  : the columns are cleared and aligned to OBSCOLALIGN bytes in one
+*          memory block as init_obscol(). the columns of all frequencies of
+*          an observable follow each other, see sdiff_obs()
+*-----------------------------------------------------------------------------*/
+extern int init_sdcol(sdcol_t *sd, int nmax)
+{
+    unsigned char *p;
+    size_t n1,n4,nf;
+    int i;
+
+    trace(3,"init_sdcol: nmax=%d\n",nmax);
+
+    nf=(size_t)(nmax+SDCOLN-1)/SDCOLN*SDCOLN*(NFREQ+NEXOBS);
+    n1=((size_t)nmax  +OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+    n4=((size_t)nmax*4+OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+
+    sd->n=sd->nmax=0;
+    sd->time.time=0; sd->time.sec=0.0;
+    if (!(sd->mem=calloc(n1+2*n4+nf*(4*8+2*4+1)+OBSCOLALIGN,1))) {
+        return 0;
+    }
+    p=(unsigned char *)sd->mem;
+    p+=(OBSCOLALIGN-(size_t)p%OBSCOLALIGN)%OBSCOLALIGN;
+
+    sd->dL[0]=(double *)p; p+=nf*8;
+    sd->dP[0]=(double *)p; p+=nf*8;
+    sd->hL   =(double *)p; p+=nf*8;
+    sd->hP   =(double *)p; p+=nf*8;
+    sd->dD[0]=(float  *)p; p+=nf*4;
+    sd->hD   =(float  *)p; p+=nf*4;
+    sd->mask[0]=p; p+=nf;
+    sd->im=(int *)p; p+=n4;
+    sd->ih=(int *)p; p+=n4;
+    sd->sat=p;
+    for (i=1;i<NFREQ+NEXOBS;i++) {
+        sd->dL  [i]=sd->dL  [0]+i*(nf/(NFREQ+NEXOBS));
+        sd->dP  [i]=sd->dP  [0]+i*(nf/(NFREQ+NEXOBS));
+        sd->dD  [i]=sd->dD  [0]+i*(nf/(NFREQ+NEXOBS));
+        sd->mask[i]=sd->mask[0]+i*(nf/(NFREQ+NEXOBS));
+    }
+    sd->nmax=nmax;
+    return 1;
+}
+/* free single differences by columns ------------------------------------------
+* free the columns of single differences between antennas
+* args   : sdcol_t *sd      IO  single differences by columns
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void free_sdcol(sdcol_t *sd)
+{
+    trace(3,"free_sdcol:\n");
+
+    free(sd->mem); sd->mem=NULL; sd->n=sd->nmax=0;
+}
+/* single differences of n column entries --------------------------------------
+* difference the master columns dL,dP,dD by the heading columns in place,
+* zero where either is zero, and set the validity masks
+*-----------------------------------------------------------------------------*/
+static void sdiff_cols(sdcol_t *sd, int i, int n)
+{
+    double *dL=sd->dL[0],*dP=sd->dP[0];
+    float *dD=sd->dD[0];
+    unsigned char *mask=sd->mask[0];
+
+    for (;i<n;i++) {
+        mask[i]=0;
+        if (dL[i]!=0.0&&sd->hL[i]!=0.0) {dL[i]-=sd->hL[i]; mask[i]|=SDVALIDL;}
+        else dL[i]=0.0;
+        if (dP[i]!=0.0&&sd->hP[i]!=0.0) {dP[i]-=sd->hP[i]; mask[i]|=SDVALIDP;}
+        else dP[i]=0.0;
+        if (dD[i]!=0.0f&&sd->hD[i]!=0.0f) {dD[i]-=sd->hD[i]; mask[i]|=SDVALIDD;}
+        else dD[i]=0.0f;
+    }
+}
+#ifdef SDIFF_AVX2
+/* spread 8 mask bits to the low bits of 8 bytes -----------------------------*/
+static unsigned long long spread8(int b)
+{
+    unsigned long long x=(unsigned long long)(b&0xFF)*0x0101010101010101ULL;
+    x&=0x8040201008040201ULL;
+    return ((x+0x7F7F7F7F7F7F7F7FULL)>>7)&0x0101010101010101ULL;
+}
+/* single differences of n column entries by avx2 ------------------------------
+* same as sdiff_cols() for 8 entries per loop from the aligned columns
+* return : number of entries done, a multiple of 8
+*-----------------------------------------------------------------------------*/
+AVX2_TARGET
+static int sdiff_cols_avx2(sdcol_t *sd, int n)
+{
+    const __m256d zero=_mm256_setzero_pd();
+    const __m256 zerof=_mm256_setzero_ps();
+    __m256d m0,m1,h0,h1,v0,v1;
+    __m256 mD,hD,vD;
+    unsigned long long b;
+    int i,bL,bP;
+
+    for (i=0;i+8<=n;i+=8) {
+        m0=_mm256_load_pd(sd->dL[0]+i  ); h0=_mm256_load_pd(sd->hL+i  );
+        m1=_mm256_load_pd(sd->dL[0]+i+4); h1=_mm256_load_pd(sd->hL+i+4);
+        v0=_mm256_and_pd(_mm256_cmp_pd(m0,zero,_CMP_NEQ_UQ),
+                         _mm256_cmp_pd(h0,zero,_CMP_NEQ_UQ));
+        v1=_mm256_and_pd(_mm256_cmp_pd(m1,zero,_CMP_NEQ_UQ),
+                         _mm256_cmp_pd(h1,zero,_CMP_NEQ_UQ));
+        _mm256_store_pd(sd->dL[0]+i  ,_mm256_and_pd(_mm256_sub_pd(m0,h0),v0));
+        _mm256_store_pd(sd->dL[0]+i+4,_mm256_and_pd(_mm256_sub_pd(m1,h1),v1));
+        bL=_mm256_movemask_pd(v0)|_mm256_movemask_pd(v1)<<4;
+
+        m0=_mm256_load_pd(sd->dP[0]+i  ); h0=_mm256_load_pd(sd->hP+i  );
+        m1=_mm256_load_pd(sd->dP[0]+i+4); h1=_mm256_load_pd(sd->hP+i+4);
+        v0=_mm256_and_pd(_mm256_cmp_pd(m0,zero,_CMP_NEQ_UQ),
+                         _mm256_cmp_pd(h0,zero,_CMP_NEQ_UQ));
+        v1=_mm256_and_pd(_mm256_cmp_pd(m1,zero,_CMP_NEQ_UQ),
+                         _mm256_cmp_pd(h1,zero,_CMP_NEQ_UQ));
+        _mm256_store_pd(sd->dP[0]+i  ,_mm256_and_pd(_mm256_sub_pd(m0,h0),v0));
+        _mm256_store_pd(sd->dP[0]+i+4,_mm256_and_pd(_mm256_sub_pd(m1,h1),v1));
+        bP=_mm256_movemask_pd(v0)|_mm256_movemask_pd(v1)<<4;
+
+        mD=_mm256_load_ps(sd->dD[0]+i); hD=_mm256_load_ps(sd->hD+i);
+        vD=_mm256_and_ps(_mm256_cmp_ps(mD,zerof,_CMP_NEQ_UQ),
+                         _mm256_cmp_ps(hD,zerof,_CMP_NEQ_UQ));
+        _mm256_store_ps(sd->dD[0]+i,_mm256_and_ps(_mm256_sub_ps(mD,hD),vD));
+
+        b=spread8(bP)*SDVALIDP|spread8(bL)*SDVALIDL|
+          spread8(_mm256_movemask_ps(vD))*SDVALIDD;
+        memcpy(sd->mask[0]+i,&b,8);
+    }
+    return i;
+}
+#endif /* SDIFF_AVX2 */
+/* single differences between antennas ----------------------------------------
+* form the single differences (master-heading) of the observation data of the
+* satellites common to two antennas
+* args   : obs_t  *obs      I   observation data of master antenna
+*          obs_t  *obsh     I   observation data of heading antenna
+*          sdcol_t *sd      IO  single differences by columns
+* return : number of common satellites
+* notes  : the common satellites are in the order of the master records. an
+*          observable is valid if it is non-zero at both antennas, the
+*          differences of invalid ones are set to 0.
+*          the observables of the common satellites are copied once into
+*          aligned columns, the master ones into dL,dP,dD and the heading
+*          ones into hL,hP,hD. the columns of the frequencies follow each
+*          other at a stride of n rounded up to SDCOLN, so all are
+*          differenced in one pass over contiguous memory, by avx2 if the
+*          cpu supports it (cpu_avx2()). dL[f] etc. are set for the stride
+*          of the epoch.
+*-----------------------------------------------------------------------------*/
+extern int sdiff_obs(const obs_t *obs, const obs_t *obsh, sdcol_t *sd)
+{
+    const obsd_t *m,*h;
+    int row[MAXSAT+1]={0};
+    int i,j,f,k,n,sat;
+
+    for (i=0;i<obsh->n&&i<MAXOBS;i++) {
+        if ((sat=obsh->data[i].sat)>0&&sat<=MAXSAT) row[sat]=i+1;
+    }
+    for (i=sd->n=0;i<obs->n&&sd->n<sd->nmax;i++) {
+        if ((sat=obs->data[i].sat)<=0||sat>MAXSAT||!row[sat]) continue;
+        sd->sat[sd->n]=(unsigned char)sat;
+        sd->im [sd->n]=i;
+        sd->ih [sd->n++]=row[sat]-1;
+    }
+    sd->time=obs->n>0?obs->data[0].time:obsh->n>0?obsh->data[0].time:sd->time;
+
+    /* columns of the frequencies at the stride of the epoch */
+    n=(sd->n+SDCOLN-1)/SDCOLN*SDCOLN;
+    for (f=1;f<NFREQ+NEXOBS;f++) {
+        sd->dL  [f]=sd->dL  [0]+f*n;
+        sd->dP  [f]=sd->dP  [0]+f*n;
+        sd->dD  [f]=sd->dD  [0]+f*n;
+        sd->mask[f]=sd->mask[0]+f*n;
+    }
+    /* copy the observables of the common satellites, zero the padding */
+    for (i=0;i<n;i++) {
+        m=i<sd->n?obs ->data+sd->im[i]:NULL;
+        h=i<sd->n?obsh->data+sd->ih[i]:NULL;
+        for (f=0,k=i;f<NFREQ+NEXOBS;f++,k+=n) {
+            sd->dL[0][k]=m?m->L[f]:0.0; sd->hL[k]=h?h->L[f]:0.0;
+            sd->dP[0][k]=m?m->P[f]:0.0; sd->hP[k]=h?h->P[f]:0.0;
+            sd->dD[0][k]=m?m->D[f]:0.0f; sd->hD[k]=h?h->D[f]:0.0f;
+        }
+    }
+    j=0;
+#ifdef SDIFF_AVX2
+    if (cpu_avx2()) j=sdiff_cols_avx2(sd,n*(NFREQ+NEXOBS));
+#endif
+    sdiff_cols(sd,j,n*(NFREQ+NEXOBS));
+    return sd->n;
+}
+/* initialize triple buffer of published epochs ------------------------------
+* initialize the triple buffer of published epochs
+* args   : rawpub_t *pub    O   triple buffer of published epochs
+* return : none
+* notes  : one writer thread calling pub_raw() and one reader thread calling
+*          read_rawpub() share the buffer without lock. call this before them.
+*-----------------------------------------------------------------------------*/
+extern void init_rawpub(rawpub_t *pub)
+{
+    trace(3,"init_rawpub:\n");
+
+    memset(pub,0,sizeof(rawpub_t));
+    pub->back=0; pub->mid=1; pub->front=2;
+}
+/* copy a part of a published epoch ------------------------------------------*/
+static void copy_pubpart(rawepoch_t *dst, const rawepoch_t *src, int part)
+{
+    switch (part) {
+        case 0: case 1:
+            dst->tobs[part]=src->tobs[part];
+            dst->nobs[part]=src->nobs[part];
+            memcpy(dst->obs[part],src->obs[part],sizeof(obsd_t)*src->nobs[part]);
+            break;
+        case 2: dst->gsof.pos=src->gsof.pos; break;
+        case 3: dst->gsof.vel=src->gsof.vel; break;
+        case 4: dst->gsof.att=src->gsof.att; break;
+        case 5:
+            dst->gsof.sat.num=src->gsof.sat.num<MAXOBS?src->gsof.sat.num:MAXOBS;
+            memcpy(dst->gsof.sat.data,src->gsof.sat.data,
+                   sizeof(gsof_satd_t)*dst->gsof.sat.num);
+            break;
+    }
+}
+/* publish decoded data --------------------------------------------------------
+* update the current epoch by the outputs of a decoded message and publish it
+* args   : rawpub_t *pub    IO  triple buffer of published epochs
+*          raw_t  *raw      I   receiver raw data control struct
+*          int    status    I   status of the decode functions
+* return : status (1:published,0:no outputs of the status)
+* notes  : the observation data (status 1,11) are kept by antenna, so those of
+*          the heading antenna do not replace those of the master antenna.
+*          a pair of epochs (status 12) updates both antennas at once, an
+*          epoch bundle (status 31) all the parts in the bundle.
+*          the parts of the back buffer changed since it was published last
+*          are copied, then it is exchanged with the middle buffer by one
+*          atomic exchange. the writer never waits for the reader.
+*-----------------------------------------------------------------------------*/
+extern int pub_raw(rawpub_t *pub, const raw_t *raw, int status)
+{
+    rawepoch_t *cur=&pub->cur,*back;
+    const obs_t *o;
+    obs_t obs;
+    int i,part;
+
+    switch (status) {
+        case 1: case 11:
+            part=raw->antno?1:0;
+            if (raw->cfg.obscol) {
+                obs.n=0; obs.nmax=MAXOBS; obs.data=cur->obs[part];
+                cur->nobs[part]=obscol2obs(&raw->ocol,&obs);
+            }
+            else {
+                cur->nobs[part]=raw->obs.n<MAXOBS?raw->obs.n:MAXOBS;
+                memcpy(cur->obs[part],raw->obs.data,sizeof(obsd_t)*cur->nobs[part]);
+            }
+            cur->tobs[part]=raw->time;
+            break;
+        case 12:
+            for (i=0;i<2;i++) {
+                o=i?&raw->obuf:&raw->obs;
+                cur->nobs[i]=o->n<MAXOBS?o->n:MAXOBS;
+                memcpy(cur->obs[i],o->data,sizeof(obsd_t)*cur->nobs[i]);
+                cur->tobs[i]=raw->tobs;
+            }
+            cur->ver[1]=++pub->ver;
+            part=0;
+            break;
+        case 31:
+            for (i=0;i<2;i++) {
+                if (!(raw->bnd.mask&(i?BNDRANGEH:BNDRANGE))) continue;
+                o=i?&raw->obuf:&raw->obs;
+                cur->nobs[i]=o->n<MAXOBS?o->n:MAXOBS;
+                memcpy(cur->obs[i],o->data,sizeof(obsd_t)*cur->nobs[i]);
+                cur->tobs[i]=raw->tobs;
+                cur->ver[i]=++pub->ver;
+            }
+            if (raw->bnd.mask&BNDPOS) {cur->gsof.pos=raw->gsof.pos; cur->ver[2]=++pub->ver;}
+            if (raw->bnd.mask&BNDVEL) {cur->gsof.vel=raw->gsof.vel; cur->ver[3]=++pub->ver;}
+            if (raw->bnd.mask&BNDATT) {cur->gsof.att=raw->gsof.att; cur->ver[4]=++pub->ver;}
+            if (raw->bnd.mask&BNDSAT) {
+                cur->gsof.sat.num=raw->gsof.sat.num<MAXOBS?raw->gsof.sat.num:MAXOBS;
+                memcpy(cur->gsof.sat.data,raw->gsof.sat.data,
+                       sizeof(gsof_satd_t)*cur->gsof.sat.num);
+                cur->ver[5]=++pub->ver;
+            }
+            part=-1;
+            break;
+        case 21: part=2; cur->gsof.pos=raw->gsof.pos; break;
+        case 22: part=3; cur->gsof.vel=raw->gsof.vel; break;
+        case 23: part=4; cur->gsof.att=raw->gsof.att; break;
+        case 24:
+            part=5;
+            cur->gsof.sat.num=raw->gsof.sat.num<MAXOBS?raw->gsof.sat.num:MAXOBS;
+            memcpy(cur->gsof.sat.data,raw->gsof.sat.data,
+                   sizeof(gsof_satd_t)*cur->gsof.sat.num);
+            break;
+        default: return 0;
+    }
+    if (part>=0) cur->ver[part]=++pub->ver;
+    cur->seq++;
+    cur->status=status;
+    cur->time=status==31?raw->tobs:raw->time;
+
+    /* bring the back buffer up to date */
+    back=pub->buf+pub->back;
+    for (i=0;i<NPUBPART;i++) {
+        if (back->ver[i]==cur->ver[i]) continue;
+        copy_pubpart(back,cur,i);
+        back->ver[i]=cur->ver[i];
+    }
+    back->seq=cur->seq;
+    back->status=cur->status;
+    back->time=cur->time;
+
+    /* publish it by exchange with the middle buffer */
+    pub->back=xchgint(&pub->mid,pub->back|PUBNEW)&~PUBNEW;
+    return 1;
+}
+/* read the latest published epoch ---------------------------------------------
+* get the latest published epoch
+* args   : rawpub_t *pub    IO  triple buffer of published epochs
+* return : latest published epoch (seq=0: no epoch published yet)
+* notes  : the epoch is kept by the writer until the next call, so it is read
+*          consistent without lock or wait.
+*-----------------------------------------------------------------------------*/
+extern const rawepoch_t *read_rawpub(rawpub_t *pub)
+{
+    if (loadint(&pub->mid)&PUBNEW) {
+        pub->front=xchgint(&pub->mid,pub->front)&~PUBNEW;
+    }
+    return pub->buf+pub->front;
+}
+/* open raw data file ----------------------------------------------------------
+* open a raw data file and map it into memory for decode_unicorem()
+* args   : rawfile_t *file  O   memory-mapped raw data file
+*          char   *path     I   file path
+* return : status (1:ok,0:error)
+* notes  : the whole file is mapped read-only with a sequential access hint,
+*          so packets are checked and decoded in place without any copy.
+*          file sizes and offsets are 64-bit, a file larger than the address
+*          space (over 4 GB on 32-bit platforms) can not be opened.
+*-----------------------------------------------------------------------------*/
+extern int open_rawfile(rawfile_t *file, const char *path)
+{
+#ifdef WIN32
+    LARGE_INTEGER size;
+#else
+    struct stat st;
+    void *p;
+#endif
+    trace(3,"open_rawfile: path=%s\n",path);
+
+    file->data=NULL;
+    file->size=file->pos=0;
+#ifdef WIN32
+    file->map=NULL;
+    file->file=CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    if (file->file==INVALID_HANDLE_VALUE) {
+        trace(2,"open_rawfile: file open error path=%s\n",path);
+        return 0;
+    }
+    if (!GetFileSizeEx(file->file,&size)||
+        (unsigned long long)size.QuadPart>(size_t)-1) {
+        trace(2,"open_rawfile: file size error path=%s\n",path);
+        close_rawfile(file);
+        return 0;
+    }
+    file->size=size.QuadPart;
+    if (file->size==0) return 1;
+
+    if (!(file->map=CreateFileMappingA(file->file,NULL,PAGE_READONLY,0,0,NULL))||
+        !(file->data=(const unsigned char *)MapViewOfFile(file->map,FILE_MAP_READ,
+                                                          0,0,0))) {
+        trace(2,"open_rawfile: file map error path=%s\n",path);
+        close_rawfile(file);
+        return 0;
+    }
+#else
+    if ((file->fd=open(path,O_RDONLY))<0) {
+        trace(2,"open_rawfile: file open error path=%s\n",path);
+        return 0;
+    }
+    if (fstat(file->fd,&st)<0||
+        (unsigned long long)st.st_size>(size_t)-1) {
+        trace(2,"open_rawfile: file size error path=%s\n",path);
+        close_rawfile(file);
+        return 0;
+    }
+    file->size=(long long)st.st_size;
+    if (file->size==0) return 1;
+
+    if ((p=mmap(NULL,(size_t)file->size,PROT_READ,MAP_PRIVATE,file->fd,0))==
+        MAP_FAILED) {
+        trace(2,"open_rawfile: file map error path=%s\n",path);
+        close_rawfile(file);
+        return 0;
+    }
+    file->data=(const unsigned char *)p;
+#ifdef MADV_SEQUENTIAL
+    madvise(p,(size_t)file->size,MADV_SEQUENTIAL);
+#endif
+#endif
+    return 1;
+}
+/* close raw data file ---------------------------------------------------------
+* unmap and close a raw data file opened by open_rawfile()
+* args   : rawfile_t *file  IO  memory-mapped raw data file
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void close_rawfile(rawfile_t *file)
+{
+    trace(3,"close_rawfile:\n");
+
+#ifdef WIN32
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->map) CloseHandle(file->map);
+    if (file->file!=INVALID_HANDLE_VALUE) CloseHandle(file->file);
+    file->map=NULL;
+    file->file=INVALID_HANDLE_VALUE;
+#else
+    if (file->data) munmap((void *)file->data,(size_t)file->size);
+    if (file->fd>=0) close(file->fd);
+    file->fd=-1;
+#endif
+    file->data=NULL;
+    file->size=file->pos=0;
+}
+/* set/get little-endian unsigned integer ----------------------------------*/
+static void setule(unsigned char *p, unsigned long long v, int n)
+{
+    int i;
+    for (i=0;i<n;i++,v>>=8) p[i]=(unsigned char)v;
+}
+static unsigned long long getule(const unsigned char *p, int n)
+{
+    unsigned long long v=0;
+    int i;
+    for (i=n-1;i>=0;i--) v=(v<<8)|p[i];
+    return v;
+}
+/* add frame record to raw data frame index ------------------------------------
+* add a frame record to the end of a raw data frame index
+* args   : rawindex_t *index IO raw data frame index
+*          rawidx_t *rec     I  frame record
+* return : status (1:ok,0:memory allocation error)
+*-----------------------------------------------------------------------------*/
+extern int add_rawindex(rawindex_t *index, const rawidx_t *rec)
+{
+    rawidx_t *data;
+
+    if (index->nmax<=index->n) {
+        if (index->nmax<=0) index->nmax=NINCRAWIDX; else index->nmax*=2;
+        if (!(data=(rawidx_t *)realloc(index->data,sizeof(rawidx_t)*index->nmax))) {
+            trace(1,"add_rawindex: memalloc error n=%dx%d\n",(int)sizeof(rawidx_t),
+                  index->nmax);
+            free(index->data); index->data=NULL; index->n=index->nmax=0;
+            return 0;
+        }
+        index->data=data;
+    }
+    index->data[index->n++]=*rec;
+    return 1;
+}
+/* free raw data frame index ---------------------------------------------------
+* free memory of a raw data frame index
+* args   : rawindex_t *index IO raw data frame index
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void free_rawindex(rawindex_t *index)
+{
+    free(index->data); index->data=NULL; index->n=index->nmax=0;
+    index->size=0;
+}
+/* write raw data frame index --------------------------------------------------
+* write a raw data frame index to a sidecar file
+* args   : char   *path      I  index file path
+*          rawindex_t *index I  raw data frame index
+* return : status (1:ok,0:file error)
+* notes  : the file is a 24 byte header followed by 20 byte frame records,
+*          all fields are little-endian:
+*            header: magic "UCIDX" (6), version (2), indexed file size (8),
+*                    number of records (4), record length (4)
+*            record: file offset (8), frame length (4), message id (2),
+*                    gps week (2), milliseconds in week (4)
+*-----------------------------------------------------------------------------*/
+extern int write_rawindex(const char *path, const rawindex_t *index)
+{
+    FILE *fp;
+    unsigned char buff[IDXHLEN];
+    int i;
+
+    trace(3,"write_rawindex: path=%s n=%d\n",path,index->n);
+
+    if (!(fp=fopen(path,"wb"))) {
+        trace(2,"write_rawindex: file open error path=%s\n",path);
+        return 0;
+    }
+    memset(buff,0,sizeof(buff));
+    memcpy(buff,IDXMAGIC,5);
+    setule(buff+ 6,IDXVER,2);
+    setule(buff+ 8,(unsigned long long)index->size,8);
+    setule(buff+16,(unsigned long long)index->n,4);
+    setule(buff+20,IDXRLEN,4);
+    fwrite(buff,IDXHLEN,1,fp);
+
+    for (i=0;i<index->n;i++) {
+        setule(buff   ,(unsigned long long)index->data[i].offset,8);
+        setule(buff+ 8,(unsigned long long)index->data[i].len,4);
+        setule(buff+12,index->data[i].msgid,2);
+        setule(buff+14,index->data[i].week,2);
+        setule(buff+16,index->data[i].ms,4);
+        fwrite(buff,IDXRLEN,1,fp);
+    }
+    if (ferror(fp)) {
+        trace(2,"write_rawindex: file write error path=%s\n",path);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    return 1;
+}
+/* read raw data frame index ---------------------------------------------------
+* read a raw data frame index from a sidecar file written by write_rawindex()
+* args   : char   *path      I  index file path
+*          rawindex_t *index IO raw data frame index (records are appended)
+* return : status (1:ok,0:file or format error)
+* notes  : index->size is set to the size of the indexed file, compare it
+*          with the raw data file to detect a stale index
+*-----------------------------------------------------------------------------*/
+extern int read_rawindex(const char *path, rawindex_t *index)
+{
+    FILE *fp;
+    unsigned char buff[IDXHLEN];
+    rawidx_t rec;
+    int i,n,rlen;
+
+    trace(3,"read_rawindex: path=%s\n",path);
+
+    if (!(fp=fopen(path,"rb"))) {
+        trace(2,"read_rawindex: file open error path=%s\n",path);
+        return 0;
+    }
+    if (fread(buff,IDXHLEN,1,fp)<1||memcmp(buff,IDXMAGIC,5)||buff[5]||
+        getule(buff+6,2)!=IDXVER||(rlen=(int)getule(buff+20,4))<IDXRLEN) {
+        trace(2,"read_rawindex: file format error path=%s\n",path);
+        fclose(fp);
+        return 0;
+    }
+    index->size=(long long)getule(buff+8,8);
+    n=(int)getule(buff+16,4);
+
+    for (i=0;i<n;i++) {
+        if (fread(buff,IDXRLEN,1,fp)<1||
+            (rlen>IDXRLEN&&fseek(fp,rlen-IDXRLEN,SEEK_CUR))) {
+            trace(2,"read_rawindex: file read error path=%s i=%d\n",path,i);
+            fclose(fp);
+            return 0;
+        }
+        rec.offset=(long long)getule(buff   ,8);
+        rec.len   =(int)getule(buff+ 8,4);
+        rec.msgid =(unsigned short)getule(buff+12,2);
+        rec.week  =(unsigned short)getule(buff+14,2);
+        rec.ms    =(unsigned int)getule(buff+16,4);
+        if (!add_rawindex(index,&rec)) {
+            fclose(fp);
+            return 0;
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+/* search raw data frame index by time -----------------------------------------
+* search the first frame at or after a time by binary search
+* args   : rawindex_t *index I  raw data frame index
+*          gtime_t time      I  time (gpst)
+* return : record number of the first frame with time >= time (index->n: none)
+* notes  : the frames have to be in time order as logged by the receiver
+*-----------------------------------------------------------------------------*/
+extern int search_rawindex(const rawindex_t *index, gtime_t time)
+{
+    long long t,key;
+    double tow;
+    int week,i=0,j=index->n,k;
+
+    tow=time2gpst(time,&week);
+    t=week*WEEKMS+(long long)floor(tow*1000.0+0.5);
+
+    while (i<j) {
+        k=i+(j-i)/2;
+        key=index->data[k].week*WEEKMS+index->data[k].ms;
+        if (key<t) i=k+1; else j=k;
+    }
+    return i;
+}
+/* initialize ephemeris history -----------------------------------------------
+* allocate the ephemeris histories of all satellites
+* args   : ephhist_t *hist  O   ephemeris history
+* return : status (1:ok,0:memory allocation error)
+*-----------------------------------------------------------------------------*/
+extern int init_ephhist(ephhist_t *hist)
+{
+    int i;
+
+    trace(3,"init_ephhist:\n");
+
+    hist->ver=0;
+    if (!(hist->sat=(ephsat_t *)malloc(sizeof(ephsat_t)*MAXSAT))) return 0;
+    for (i=0;i<MAXSAT;i++) hist->sat[i].n=0;
+    return 1;
+}
+/* free ephemeris history ------------------------------------------------------
+* free the ephemeris histories of all satellites
+* args   : ephhist_t *hist  IO  ephemeris history
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void free_ephhist(ephhist_t *hist)
+{
+    trace(3,"free_ephhist:\n");
+
+    free(hist->sat); hist->sat=NULL;
+}
+/* issue of data of ephemeris (BDS: AODE) ------------------------------------*/
+static int eph_iode(const eph_t *eph)
+{
+    return satsys(eph->sat,NULL)==SYS_BDS?eph->aode:eph->iode;
+}
+/* time key of ephemeris history (s) -----------------------------------------*/
+static double ephkey(gtime_t t)
+{
+    return (double)t.time+t.sec;
+}
+/* orbit constants of ephemeris ---------------------------------------------*/
+static void set_ephorb(const eph_t *eph, ephorb_t *orb)
+{
+    double mu=MU_GPS;
+    int prn,sys=satsys(eph->sat,&prn);
+
+    orb->type=0;
+    if (eph->A<=0.0) return;
+
+    orb->omge=OMGE;
+    if (sys==SYS_BDS) {mu=MU_BDS; orb->omge=OMGE_BDS;}
+    orb->type=sys==SYS_BDS&&(prn<=5||prn>=59)?2:1; /* BDS GEO: prn 1-5,59- */
+    orb->n   =sqrt(mu/(eph->A*eph->A*eph->A))+eph->deln;
+    orb->sqe =sqrt(1.0-eph->e*eph->e);
+    orb->sinw=sin(eph->omg); orb->cosw=cos(eph->omg);
+    orb->sini=sin(eph->i0 ); orb->cosi=cos(eph->i0 );
+    orb->OMG0=eph->OMG0-orb->omge*eph->toes;
+    orb->OMGd=orb->type==2?eph->OMGd:eph->OMGd-orb->omge;
+    orb->frel=-2.0*sqrt(mu*eph->A)*eph->e/(CLIGHT*CLIGHT);
+}
+/* search ephemeris history by toe ---------------------------------------------
+* number of the first ephemeris with toe > key by binary search */
+static int search_ephsat(const ephsat_t *h, double key)
+{
+    int i=0,j=h->n,k;
+
+    while (i<j) {
+        k=i+(j-i)/2;
+        if (h->toe[k]<=key) i=k+1; else j=k;
+    }
+    return i;
+}
+/* add ephemeris to ephemeris history ------------------------------------------
+* add an ephemeris to the history of the satellite
+* args   : ephhist_t *hist  IO  ephemeris history
+*          eph_t  *eph      I   ephemeris
+* return : status (1:added,0:not added)
+* notes  : the ephemerides are keyed by toe and IODE (BDS: AODE). one of the
+*          same toe and IODE is replaced, the ephemerides are kept in toe order
+*          and of the same toe in the order added. with NEPHHIST ephemerides the
+*          one of the oldest toe is dropped, an ephemeris older than all is
+*          not added. every ephemeris added gets a new version hist->ver, so
+*          data derived from an ephemeris are valid while its version is.
+*          the orbit constants of the ephemeris are computed once here
+*          toe and slots of the satellite are in the first cache lines of
+*          ephsat_t, only the ephemeris selected is read by select_eph()
+*-----------------------------------------------------------------------------*/
+extern int add_ephhist(ephhist_t *hist, const eph_t *eph)
+{
+    ephsat_t *h;
+    double key;
+    int i,k,slot;
+
+    trace(4,"add_ephhist: sat=%d iode=%d\n",eph->sat,eph->iode);
+
+    if (!hist->sat||eph->sat<=0||eph->sat>MAXSAT) return 0;
+    h=hist->sat+eph->sat-1;
+    key=ephkey(eph->toe);
+    i=search_ephsat(h,key);
+
+    /* replace the ephemeris of the same toe and IODE */
+    for (k=i-1;k>=0&&h->toe[k]==key;k--) {
+        slot=h->slot[k];
+        if (eph_iode(h->eph+slot)!=eph_iode(eph)) continue;
+        memmove(h->slot+k,h->slot+k+1,i-1-k);
+        h->slot[i-1]=(unsigned char)slot;
+        h->eph[slot]=*eph;
+        h->ver[slot]=++hist->ver;
+        set_ephorb(eph,h->orb+slot);
+        return 1;
+    }
+    /* insert at i, the slot of the oldest is reused if full */
+    if (h->n>=NEPHHIST) {
+        if (i==0) return 0;
+        slot=h->slot[0];
+        memmove(h->toe,h->toe+1,sizeof(double)*(i-1));
+        memmove(h->slot,h->slot+1,i-1);
+        i--;
+    }
+    else {
+        slot=h->n;
+        memmove(h->toe+i+1,h->toe+i,sizeof(double)*(h->n-i));
+        memmove(h->slot+i+1,h->slot+i,h->n-i);
+        h->n++;
+    }
+    h->toe [i]=key;
+    h->slot[i]=(unsigned char)slot;
+    h->eph[slot]=*eph;
+    h->ver[slot]=++hist->ver;
+    set_ephorb(eph,h->orb+slot);
+    return 1;
+}
+/* select ephemeris from ephemeris history -------------------------------------
+* select the ephemeris of the satellite for a time
+* args   : ephhist_t *hist  I   ephemeris history
+*          int    sat       I   satellite number
+*          gtime_t time     I   time (gpst)
+*          int    iode      I   IODE (BDS: AODE) (-1: any)
+* return : ephemeris (NULL: no ephemeris)
+* notes  : the ephemeris of the nearest toe within MAXDTOE (MAXDTOE_??? by
+*          system) is selected by binary search, the last added of the same
+*          toe. with iode>=0 the last added of the IODE within MAXDTOE.
+*          the ephemeris is valid until the next add_ephhist() of satellite
+*-----------------------------------------------------------------------------*/
+extern const eph_t *select_eph(const ephhist_t *hist, int sat, gtime_t time,
+                               int iode)
+{
+    const ephsat_t *h;
+    double key,tmax;
+    int i,j,k;
+
+    trace(4,"select_eph: sat=%d iode=%d\n",sat,iode);
+
+    if (!hist->sat||sat<=0||sat>MAXSAT) return NULL;
+    h=hist->sat+sat-1;
+    key=ephkey(time);
+
+    switch (satsys(sat,NULL)) {
+        case SYS_QZS: tmax=MAXDTOE_QZS+1.0; break;
+        case SYS_GAL: tmax=MAXDTOE_GAL+1.0; break;
+        case SYS_BDS: tmax=MAXDTOE_BDS+1.0; break;
+        default:      tmax=MAXDTOE    +1.0; break;
+    }
+    if (iode>=0) {
+        for (k=h->n-1;k>=0;k--) {
+            if (eph_iode(h->eph+h->slot[k])!=iode||fabs(h->toe[k]-key)>tmax) continue;
+            return h->eph+h->slot[k];
+        }
+        return NULL;
+    }
+    /* last at or before time and last of the first toe after time */
+    i=search_ephsat(h,key);
+    for (j=i;j+1<h->n&&h->toe[j+1]==h->toe[i];j++) ;
+
+    if (i>0&&(i>=h->n||key-h->toe[i-1]<=h->toe[j]-key)) k=i-1;
+    else if (i<h->n) k=j;
+    else return NULL;
+
+    if (fabs(h->toe[k]-key)>tmax) return NULL;
+    return h->eph+h->slot[k];
+}
+/* initialize satellite positions by columns ----------------------------------
+* allocate the columns of satellite positions and clocks
+* args   : satcol_t *sc     O   satellite positions by columns
+*          int    nmax      I   max number of satellites
+* return : status (1:ok,0:memory allocation error)
+* notes  : the columns are aligned to OBSCOLALIGN bytes in one memory block
+*          as init_obscol()
+*-----------------------------------------------------------------------------*/
+extern int init_satcol(satcol_t *sc, int nmax)
+{
+    unsigned char *p;
+    size_t n1,n4,n8;
+
+    trace(3,"init_satcol: nmax=%d\n",nmax);
+
+    n1=((size_t)nmax  +OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+    n4=((size_t)nmax*4+OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+    n8=((size_t)nmax*8+OBSCOLALIGN-1)/OBSCOLALIGN*OBSCOLALIGN;
+
+    sc->n=sc->nmax=0;
+    sc->time.time=0; sc->time.sec=0.0;
+    if (!(sc->mem=calloc(n1+n4+7*n8+OBSCOLALIGN,1))) return 0;
+    p=(unsigned char *)sc->mem;
+    p+=(OBSCOLALIGN-(size_t)p%OBSCOLALIGN)%OBSCOLALIGN;
+
+    sc->x  =(double *)p; p+=n8;
+    sc->y  =(double *)p; p+=n8;
+    sc->z  =(double *)p; p+=n8;
+    sc->dts=(double *)p; p+=n8;
+    sc->tgd=(double *)p; p+=n8;
+    sc->az =(double *)p; p+=n8;
+    sc->el =(double *)p; p+=n8;
+    sc->svh=(int    *)p; p+=n4;
+    sc->sat=p;
+    sc->nmax=nmax;
+    return 1;
+}
+/* free satellite positions by columns -----------------------------------------
+* free the columns of satellite positions and clocks
+* args   : satcol_t *sc     IO  satellite positions by columns
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void free_satcol(satcol_t *sc)
+{
+    trace(3,"free_satcol:\n");
+
+    free(sc->mem); sc->mem=NULL; sc->n=sc->nmax=0;
+}
+/* satellite positions and clocks of a block of satellites ---------------------
+* each step is a loop over the columns of the block, the ephemeris fields are
+* gathered to the columns first */
+static void satpos_blk(gtime_t time, const eph_t **eph, const ephorb_t **orb,
+                       int m, satcol_t *sc)
+{
+    double tk[SATBLK],M[SATBLK],ec[SATBLK],E[SATBLK],sinE[SATBLK],cosE[SATBLK];
+    double A[SATBLK],cus[SATBLK],cuc[SATBLK],crs[SATBLK],crc[SATBLK];
+    double cis[SATBLK],cic[SATBLK],idot[SATBLK],sqe[SATBLK],sinw[SATBLK];
+    double cosw[SATBLK],sini[SATBLK],cosi[SATBLK],O[SATBLK],sinO[SATBLK];
+    double cosO[SATBLK],x[SATBLK],y[SATBLK];
+    double d,sv,cv,s0,c0,s2,c2,du,di,sdu,cdu,sdi,cdi,r,xg,yg,zg,so,co,t,ts,Ek;
+    double *px=sc->x+sc->n,*py=sc->y+sc->n,*pz=sc->z+sc->n;
+    int i,j;
+
+    /* gather */
+    for (j=0;j<m;j++) {
+        tk[j]=timediff(time,eph[j]->toe);
+        M [j]=eph[j]->M0+orb[j]->n*tk[j];
+        E [j]=M[j];
+        ec[j]=eph[j]->e;    A  [j]=eph[j]->A;
+        cus[j]=eph[j]->cus; cuc[j]=eph[j]->cuc;
+        crs[j]=eph[j]->crs; crc[j]=eph[j]->crc;
+        cis[j]=eph[j]->cis; cic[j]=eph[j]->cic;
+        idot[j]=eph[j]->idot;
+        sqe [j]=orb[j]->sqe;
+        sinw[j]=orb[j]->sinw; cosw[j]=orb[j]->cosw;
+        sini[j]=orb[j]->sini; cosi[j]=orb[j]->cosi;
+        O   [j]=orb[j]->OMG0+orb[j]->OMGd*tk[j];
+    }
+    /* Kepler equation by Newton iterations of all satellites */
+    for (i=0;i<NKEPLER;i++) for (j=0;j<m;j++) {
+        E[j]-=(E[j]-ec[j]*sin(E[j])-M[j])/(1.0-ec[j]*cos(E[j]));
+    }
+    for (j=0;j<m;j++) {
+        sinE[j]=sin(E[j]);
+        cosE[j]=cos(E[j]);
+    }
+    for (j=0;j<m;j++) {
+        if (fabs(E[j]-ec[j]*sinE[j]-M[j])<RTOL_KEPLER*(1.0-ec[j]*cosE[j])) continue;
+
+        /* not converged yet */
+        for (i=0,Ek=0.0;fabs(E[j]-Ek)>RTOL_KEPLER&&i<MAX_ITER_KEPLER;i++) {
+            Ek=E[j]; E[j]-=(E[j]-ec[j]*sin(E[j])-M[j])/(1.0-ec[j]*cos(E[j]));
+        }
+        if (i>=MAX_ITER_KEPLER) trace(2,"kepler iteration overflow sat=%2d\n",eph[j]->sat);
+        sinE[j]=sin(E[j]);
+        cosE[j]=cos(E[j]);
+    }
+    /* position in orbital plane, the argument of latitude by sin/cos of the
+       true anomaly and of omg, its small corrections by series */
+    for (j=0;j<m;j++) {
+        d =1.0-ec[j]*cosE[j];
+        sv=sqe[j]*sinE[j]/d;
+        cv=(cosE[j]-ec[j])/d;
+        s0=sv*cosw[j]+cv*sinw[j];
+        c0=cv*cosw[j]-sv*sinw[j];
+        s2=2.0*s0*c0;
+        c2=c0*c0-s0*s0;
+        du=cus[j]*s2+cuc[j]*c2;
+        di=idot[j]*tk[j]+cis[j]*s2+cic[j]*c2;
+        r =A[j]*d+crs[j]*s2+crc[j]*c2;
+        sdu=du*(1.0-du*du/6.0); cdu=1.0-du*du*(0.5-du*du/24.0);
+        sdi=di*(1.0-di*di/6.0); cdi=1.0-di*di*(0.5-di*di/24.0);
+        x[j]=r*(c0*cdu-s0*sdu);
+        y[j]=r*(s0*cdu+c0*sdu);
+        s0=sini[j]*cdi+cosi[j]*sdi;
+        c0=cosi[j]*cdi-sini[j]*sdi;
+        sini[j]=s0;
+        cosi[j]=c0;
+    }
+    for (j=0;j<m;j++) {
+        sinO[j]=sin(O[j]);
+        cosO[j]=cos(O[j]);
+    }
+    for (j=0;j<m;j++) {
+        px[j]=x[j]*cosO[j]-y[j]*cosi[j]*sinO[j];
+        py[j]=x[j]*sinO[j]+y[j]*cosi[j]*cosO[j];
+        pz[j]=y[j]*sini[j];
+    }
+    /* BDS GEO satellites */
+    for (j=0;j<m;j++) {
+        if (orb[j]->type!=2) continue;
+        xg=px[j]; yg=py[j]; zg=pz[j];
+        so=sin(orb[j]->omge*tk[j]);
+        co=cos(orb[j]->omge*tk[j]);
+        px[j]= xg*co+yg*so*COS_5+zg*so*SIN_5;
+        py[j]=-xg*so+yg*co*COS_5+zg*co*SIN_5;
+        pz[j]=-yg*SIN_5+zg*COS_5;
+    }
+    /* satellite clocks with relativity */
+    for (j=0;j<m;j++) {
+        t=ts=timediff(time,eph[j]->toc);
+        for (i=0;i<2;i++) t=ts-(eph[j]->f0+eph[j]->f1*t+eph[j]->f2*t*t);
+        sc->dts[sc->n+j]=eph[j]->f0+eph[j]->f1*t+eph[j]->f2*t*t+orb[j]->frel*sinE[j];
+        sc->tgd[sc->n+j]=eph[j]->tgd[0];
+        sc->svh[sc->n+j]=eph[j]->svh;
+        sc->sat[sc->n+j]=(unsigned char)eph[j]->sat;
+    }
+    sc->n+=m;
+}
+/* satellite positions and clocks by columns -----------------------------------
+* compute satellite positions and clocks of satellites at a time by the
+* broadcast ephemerides of the ephemeris history
+* args   : ephhist_t *hist  I   ephemeris history
+*          gtime_t time     I   time (gpst)
+*          int    *sat      I   satellite numbers
+*          int    n         I   number of satellites
+*          satcol_t *sc     IO  satellite positions by columns
+* return : number of satellites in the columns
+* notes  : time is the signal transmission time, the receiver time can be
+*          used to check azimuth/elevation angles. the ephemerides are
+*          selected by select_eph(), satellites without ephemeris or with an
+*          invalid one are left out of the columns.
+*          the clock biases include relativity, the group delay is not
+*          applied, for GPS L1 and BDS B1 take dts-tgd.
+*          the satellites are computed in blocks of SATBLK, each step a loop
+*          over the block with the constants computed by add_ephhist(). the
+*          sin/cos of the arguments of latitude and inclination come from
+*          those of the true anomaly, omg and i0, sin/cos left are of E and
+*          the node (BDS GEO: and earth rotation) only
+*-----------------------------------------------------------------------------*/
+extern int satpos_col(const ephhist_t *hist, gtime_t time, const int *sat,
+                      int n, satcol_t *sc)
+{
+    const eph_t *eph[SATBLK],*p;
+    const ephorb_t *orb[SATBLK];
+    const ephorb_t *o;
+    int i=0,m;
+
+    trace(3,"satpos_col: n=%d\n",n);
+
+    sc->time=time;
+    sc->n=0;
+    while (i<n&&sc->n<sc->nmax) {
+        for (m=0;i<n&&m<SATBLK&&sc->n+m<sc->nmax;i++) {
+            if (!(p=select_eph(hist,sat[i],time,-1))) continue;
+            o=hist->sat[sat[i]-1].orb+(p-hist->sat[sat[i]-1].eph);
+            if (!o->type) continue;
+            eph[m]=p; orb[m++]=o;
+        }
+        satpos_blk(time,eph,orb,m,sc);
+    }
+    return sc->n;
+}
+/* satellite azimuth/elevation angles by columns -------------------------------
+* compute azimuth/elevation angles of the satellites from a receiver
+* args   : satcol_t *sc     IO  satellite positions by columns
+*          double *rr       I   receiver position (ecef) (m)
+* return : none
+* notes  : the angles are for sc->az[], sc->el[] (rad), with the receiver
+*          under the earth surface (e.g. rr={0,0,0}) az=0 and el=pi/2
+*-----------------------------------------------------------------------------*/
+extern void satazel_col(satcol_t *sc, const double *rr)
+{
+    double pos[3],sinp,cosp,sinl,cosl,dx,dy,dz,e,n,u;
+    int i;
+
+    ecef2pos(rr,pos);
+    if (pos[2]<=-RE_WGS84) {
+        for (i=0;i<sc->n;i++) {sc->az[i]=0.0; sc->el[i]=PI/2.0;}
+        return;
+    }
+    sinp=sin(pos[0]); cosp=cos(pos[0]); sinl=sin(pos[1]); cosl=cos(pos[1]);
+
+    for (i=0;i<sc->n;i++) {
+        dx=sc->x[i]-rr[0]; dy=sc->y[i]-rr[1]; dz=sc->z[i]-rr[2];
+        e=-sinl*dx+cosl*dy;
+        n=-sinp*cosl*dx-sinp*sinl*dy+cosp*dz;
+        u= cosp*cosl*dx+cosp*sinl*dy+sinp*dz;
+        sc->az[i]=atan2(e,n);
+        if (sc->az[i]<0.0) sc->az[i]+=2.0*PI;
+        sc->el[i]=asin(u/sqrt(e*e+n*n+u*u));
+    }
+}
 /* satellite number to satellite system + prn----------------------------------
 * convert satellite number to satellite system + prn
 * args   : int    sat       I   satellite number (1-MAXSAT)
@@ -277,6 +1571,316 @@ extern unsigned int crc32(const unsigned char *buff, int len)
     return crc;
 }
 
+/* crc-32 tables -------------------------------------------------------------*/
+static unsigned int crc32tbl[16][256]; /* slicing-by-16 tables */
+static int crc32tbl_init=0;
+
+static void init_crc32tbl(void)
+{
+    unsigned int crc;
+    int i,j;
+
+    if (crc32tbl_init) return;
+
+    for (i=0;i<256;i++) {
+        crc=(unsigned int)i;
+        for (j=0;j<8;j++) crc=(crc&1)?(crc>>1)^POLYCRC32:crc>>1;
+        crc32tbl[0][i]=crc;
+    }
+    for (i=0;i<256;i++) for (j=1;j<16;j++) {
+        crc=crc32tbl[j-1][i];
+        crc32tbl[j][i]=(crc>>8)^crc32tbl[0][crc&0xFF];
+    }
+    crc32tbl_init=1;
+}
+/* little-endian 32 bit load -------------------------------------------------*/
+static unsigned int load_u4le(const unsigned char *p)
+{
+    return (unsigned int)p[0]|((unsigned int)p[1]<<8)|((unsigned int)p[2]<<16)|
+           ((unsigned int)p[3]<<24);
+}
+/* crc-32 parity by slicing-by-8 -----------------------------------------------
+* update crc-32 parity for novatel raw with 8 bytes per table lookup round
+* args   : unsigned int crc  I  crc-32 parity of preceding data (0: start)
+*          unsigned char *buff I data
+*          int    len    I      data length (bytes)
+* return : crc-32 parity
+* notes  : crc32_s8(0,buff,len)==crc32(buff,len)
+*-----------------------------------------------------------------------------*/
+extern unsigned int crc32_s8(unsigned int crc, const unsigned char *buff,
+                             int len)
+{
+    const unsigned int (*t)[256]=(const unsigned int (*)[256])crc32tbl;
+    unsigned int one,two;
+
+    init_crc32tbl();
+
+    for (;len>=8;len-=8,buff+=8) {
+        one=load_u4le(buff)^crc;
+        two=load_u4le(buff+4);
+        crc=t[7][one&0xFF]^t[6][(one>>8)&0xFF]^t[5][(one>>16)&0xFF]^t[4][one>>24]^
+            t[3][two&0xFF]^t[2][(two>>8)&0xFF]^t[1][(two>>16)&0xFF]^t[0][two>>24];
+    }
+    for (;len>0;len--) crc=(crc>>8)^t[0][(crc^*buff++)&0xFF];
+    return crc;
+}
+/* crc-32 parity by slicing-by-16 ----------------------------------------------
+* update crc-32 parity for novatel raw with 16 bytes per table lookup round
+* args   : unsigned int crc  I  crc-32 parity of preceding data (0: start)
+*          unsigned char *buff I data
+*          int    len    I      data length (bytes)
+* return : crc-32 parity
+* notes  : crc32_s16(0,buff,len)==crc32(buff,len)
+*-----------------------------------------------------------------------------*/
+extern unsigned int crc32_s16(unsigned int crc, const unsigned char *buff,
+                              int len)
+{
+    const unsigned int (*t)[256]=(const unsigned int (*)[256])crc32tbl;
+    unsigned int one,two,three,four;
+
+    init_crc32tbl();
+
+    for (;len>=16;len-=16,buff+=16) {
+        one  =load_u4le(buff)^crc;
+        two  =load_u4le(buff+4);
+        three=load_u4le(buff+8);
+        four =load_u4le(buff+12);
+        crc=t[15][one  &0xFF]^t[14][(one  >>8)&0xFF]^t[13][(one  >>16)&0xFF]^t[12][one  >>24]^
+            t[11][two  &0xFF]^t[10][(two  >>8)&0xFF]^t[ 9][(two  >>16)&0xFF]^t[ 8][two  >>24]^
+            t[ 7][three&0xFF]^t[ 6][(three>>8)&0xFF]^t[ 5][(three>>16)&0xFF]^t[ 4][three>>24]^
+            t[ 3][four &0xFF]^t[ 2][(four >>8)&0xFF]^t[ 1][(four >>16)&0xFF]^t[ 0][four >>24];
+    }
+    for (;len>0;len--) crc=(crc>>8)^t[0][(crc^*buff++)&0xFF];
+    return crc;
+}
+#ifdef CRC32_PCLMUL
+/* crc-32 folding by pclmulqdq for 64 bytes or more, multiple of 16 ----------*/
+CRC32_TARGET
+static unsigned int crc32_fold(unsigned int crc, const unsigned char *buff,
+                               int len)
+{
+    /* folding constants for reflected 0xEDB88320 (x^(4*128+-32) mod P etc.) */
+    static const unsigned long long k1k2[2]={0x0154442bd4ULL,0x01c6e41596ULL};
+    static const unsigned long long k3k4[2]={0x01751997d0ULL,0x00ccaa009eULL};
+    static const unsigned long long k5  [2]={0x0163cd6124ULL,0x0000000000ULL};
+    static const unsigned long long poly[2]={0x01db710641ULL,0x01f7011641ULL};
+    __m128i x0,x1,x2,x3,x4,x5,x6,x7,x8;
+
+    x1=_mm_loadu_si128((const __m128i *)(buff     ));
+    x2=_mm_loadu_si128((const __m128i *)(buff+0x10));
+    x3=_mm_loadu_si128((const __m128i *)(buff+0x20));
+    x4=_mm_loadu_si128((const __m128i *)(buff+0x30));
+    x1=_mm_xor_si128(x1,_mm_cvtsi32_si128((int)crc));
+    x0=_mm_loadu_si128((const __m128i *)k1k2);
+    buff+=64; len-=64;
+
+    /* fold 4 x 128 bits in parallel */
+    for (;len>=64;len-=64,buff+=64) {
+        x5=_mm_clmulepi64_si128(x1,x0,0x00);
+        x6=_mm_clmulepi64_si128(x2,x0,0x00);
+        x7=_mm_clmulepi64_si128(x3,x0,0x00);
+        x8=_mm_clmulepi64_si128(x4,x0,0x00);
+        x1=_mm_clmulepi64_si128(x1,x0,0x11);
+        x2=_mm_clmulepi64_si128(x2,x0,0x11);
+        x3=_mm_clmulepi64_si128(x3,x0,0x11);
+        x4=_mm_clmulepi64_si128(x4,x0,0x11);
+        x1=_mm_xor_si128(_mm_xor_si128(x1,x5),_mm_loadu_si128((const __m128i *)(buff     )));
+        x2=_mm_xor_si128(_mm_xor_si128(x2,x6),_mm_loadu_si128((const __m128i *)(buff+0x10)));
+        x3=_mm_xor_si128(_mm_xor_si128(x3,x7),_mm_loadu_si128((const __m128i *)(buff+0x20)));
+        x4=_mm_xor_si128(_mm_xor_si128(x4,x8),_mm_loadu_si128((const __m128i *)(buff+0x30)));
+    }
+    /* fold into 128 bits */
+    x0=_mm_loadu_si128((const __m128i *)k3k4);
+    x5=_mm_clmulepi64_si128(x1,x0,0x00);
+    x1=_mm_clmulepi64_si128(x1,x0,0x11);
+    x1=_mm_xor_si128(_mm_xor_si128(x1,x2),x5);
+    x5=_mm_clmulepi64_si128(x1,x0,0x00);
+    x1=_mm_clmulepi64_si128(x1,x0,0x11);
+    x1=_mm_xor_si128(_mm_xor_si128(x1,x3),x5);
+    x5=_mm_clmulepi64_si128(x1,x0,0x00);
+    x1=_mm_clmulepi64_si128(x1,x0,0x11);
+    x1=_mm_xor_si128(_mm_xor_si128(x1,x4),x5);
+
+    /* fold remaining 128 bit blocks */
+    for (;len>=16;len-=16,buff+=16) {
+        x5=_mm_clmulepi64_si128(x1,x0,0x00);
+        x1=_mm_clmulepi64_si128(x1,x0,0x11);
+        x1=_mm_xor_si128(_mm_xor_si128(x1,_mm_loadu_si128((const __m128i *)buff)),x5);
+    }
+    /* fold 128 bits to 64 bits */
+    x2=_mm_clmulepi64_si128(x1,x0,0x10);
+    x3=_mm_setr_epi32(~0,0,~0,0);
+    x1=_mm_xor_si128(_mm_srli_si128(x1,8),x2);
+    x0=_mm_loadl_epi64((const __m128i *)k5);
+    x2=_mm_srli_si128(x1,4);
+    x1=_mm_and_si128(x1,x3);
+    x1=_mm_clmulepi64_si128(x1,x0,0x00);
+    x1=_mm_xor_si128(x1,x2);
+
+    /* barrett reduction to 32 bits */
+    x0=_mm_loadu_si128((const __m128i *)poly);
+    x2=_mm_and_si128(x1,x3);
+    x2=_mm_clmulepi64_si128(x2,x0,0x10);
+    x2=_mm_and_si128(x2,x3);
+    x2=_mm_clmulepi64_si128(x2,x0,0x00);
+    x1=_mm_xor_si128(x1,x2);
+
+    return (unsigned int)_mm_extract_epi32(x1,1);
+}
+/* cpu support of pclmulqdq and sse4.1 ---------------------------------------*/
+static int cpu_pclmul(void)
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info,1);
+    return (info[2]&(1<<1))&&(info[2]&(1<<19));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul")&&__builtin_cpu_supports("sse4.1");
+#endif
+}
+#endif /* CRC32_PCLMUL */
+/* crc-32 parity by pclmulqdq folding ------------------------------------------
+* update crc-32 parity for novatel raw by carry-less multiplication folding
+* args   : unsigned int crc  I  crc-32 parity of preceding data (0: start)
+*          unsigned char *buff I data
+*          int    len    I      data length (bytes)
+* return : crc-32 parity
+* notes  : crc32_pclmul(0,buff,len)==crc32(buff,len)
+*          the cpu must support pclmulqdq and sse4.1 (see crc32_engine()),
+*          data shorter than 64 bytes and the tail are done by slicing-by-16.
+*          same as crc32_s16() if no x86 pclmulqdq support is compiled in
+*-----------------------------------------------------------------------------*/
+extern unsigned int crc32_pclmul(unsigned int crc, const unsigned char *buff,
+                                 int len)
+{
+#ifdef CRC32_PCLMUL
+    int n=len&~15;
+
+    if (n>=64) {
+        crc=crc32_fold(crc,buff,n);
+        buff+=n; len-=n;
+    }
+#endif
+    return crc32_s16(crc,buff,len);
+}
+/* bitwise crc-32 as engine --------------------------------------------------*/
+static unsigned int crc32_bit(unsigned int crc, const unsigned char *buff,
+                              int len)
+{
+    int i,j;
+
+    for (i=0;i<len;i++) {
+        crc^=buff[i];
+        for (j=0;j<8;j++) crc=(crc&1)?(crc>>1)^POLYCRC32:crc>>1;
+    }
+    return crc;
+}
+/* crc-32 engine selection ---------------------------------------------------*/
+static unsigned int crc32_select(unsigned int crc, const unsigned char *buff,
+                                 int len);
+
+static crc32_func_t crc32_func=crc32_select;
+static const char *crc32_name="none";
+
+/* check crc-32 engine against bitwise reference -----------------------------*/
+static int check_crc32(crc32_func_t func)
+{
+    unsigned char data[1024+13];
+    unsigned int crc;
+    int i,n;
+
+    for (i=0;i<(int)sizeof(data);i++) data[i]=(unsigned char)(i*131+(i>>3));
+
+    for (n=0;n<=(int)sizeof(data);n+=n<80?1:97) {
+        if (func(0,data,n)!=crc32(data,n)) return 0;
+
+        /* split update */
+        crc=func(0,data,n/3);
+        if (func(crc,data+n/3,n-n/3)!=crc32(data,n)) return 0;
+    }
+    return 1;
+}
+static unsigned int crc32_select(unsigned int crc, const unsigned char *buff,
+                                 int len)
+{
+    crc32_func_t func=crc32_bit;
+    const char *name="bitwise";
+
+    init_crc32tbl();
+
+    if (check_crc32(crc32_s8)) {func=crc32_s8; name="slicing-by-8";}
+    if (check_crc32(crc32_s16)) {func=crc32_s16; name="slicing-by-16";}
+#ifdef CRC32_PCLMUL
+    if (cpu_pclmul()&&check_crc32(crc32_pclmul)) {
+        func=crc32_pclmul; name="pclmulqdq";
+    }
+#endif
+    trace(3,"crc32_select: engine=%s\n",name);
+
+    crc32_name=name;
+    crc32_func=func;
+    return func(crc,buff,len);
+}
+/* update crc-32 parity --------------------------------------------------------
+* update crc-32 parity for novatel raw with the fastest engine on this cpu
+* args   : unsigned int crc  I  crc-32 parity of preceding data (0: start)
+*          unsigned char *buff I data
+*          int    len    I      data length (bytes)
+* return : crc-32 parity
+* notes  : crc32_update(0,buff,len)==crc32(buff,len)
+*          the engine is selected at the first call (pclmulqdq, slicing-by-16,
+*          slicing-by-8) and checked against crc32() before use
+*-----------------------------------------------------------------------------*/
+extern unsigned int crc32_update(unsigned int crc, const unsigned char *buff,
+                                 int len)
+{
+    /* short updates while a packet arrives go byte by byte */
+    if (len<16&&crc32tbl_init) {
+        for (;len>0;len--) crc=(crc>>8)^crc32tbl[0][(crc^*buff++)&0xFF];
+        return crc;
+    }
+    return crc32_func(crc,buff,len);
+}
+/* crc-32 engine name ----------------------------------------------------------
+* get the name of the crc-32 engine used by crc32_update()
+* args   : none
+* return : engine name ("pclmulqdq","slicing-by-16","slicing-by-8","bitwise")
+*-----------------------------------------------------------------------------*/
+extern const char *crc32_engine(void)
+{
+    if (crc32_func==crc32_select) crc32_update(0,NULL,0);
+    return crc32_name;
+}
+/* cpu support of avx2 ---------------------------------------------------------
+* check if the cpu and os support avx2 to select avx2 kernels at run time
+* args   : none
+* return : 1: avx2 supported, 0: not supported or not x86
+* notes  : the result is checked at the first call and kept
+*-----------------------------------------------------------------------------*/
+extern int cpu_avx2(void)
+{
+    static int avx2=-1;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+
+    if (avx2<0) {
+        __cpuid(info,1);
+        avx2=(info[2]&(1<<27))&&(info[2]&(1<<28))&&(_xgetbv(0)&6)==6;
+        __cpuidex(info,7,0);
+        avx2=avx2&&(info[1]&(1<<5));
+    }
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (avx2<0) {
+        __builtin_cpu_init();
+        avx2=__builtin_cpu_supports("avx2")?1:0;
+    }
+#else
+    avx2=0;
+#endif
+    return avx2;
+}
+
 /* convert calendar day/time to time -------------------------------------------
 * convert calendar day/time to gtime_t struct
 * args   : double *ep       I   day/time {year,month,day,hour,min,sec}
@@ -463,5 +2067,40 @@ extern double timediff(gtime_t t1, gtime_t t2)
 {
     return difftime(t1.time,t2.time)+t1.sec-t2.sec;
 }
+/* transform ecef to geodetic postion ------------------------------------------
+* transform ecef position to geodetic position
+* args   : double *r        I   ecef position {x,y,z} (m)
+*          double *pos      O   geodetic position {lat,lon,h} (rad,m)
+* return : none
+* notes  : WGS84, ellipsoidal height
+*-----------------------------------------------------------------------------*/
+extern void ecef2pos(const double *r, double *pos)
+{
+    double e2=FE_WGS84*(2.0-FE_WGS84),r2=r[0]*r[0]+r[1]*r[1],z,zk,v=RE_WGS84,sinp;
 
+    for (z=r[2],zk=0.0;fabs(z-zk)>=1E-4;) {
+        zk=z;
+        sinp=z/sqrt(r2+z*z);
+        v=RE_WGS84/sqrt(1.0-e2*sinp*sinp);
+        z=r[2]+v*e2*sinp;
+    }
+    pos[0]=r2>1E-12?atan(z/sqrt(r2)):(r[2]>0.0?PI/2.0:-PI/2.0);
+    pos[1]=r2>1E-12?atan2(r[1],r[0]):0.0;
+    pos[2]=sqrt(r2+z*z)-v;
+}
+/* transform geodetic to ecef position -----------------------------------------
+* transform geodetic position to ecef position
+* args   : double *pos      I   geodetic position {lat,lon,h} (rad,m)
+*          double *r        O   ecef position {x,y,z} (m)
+* return : none
+* notes  : WGS84, ellipsoidal height
+*-----------------------------------------------------------------------------*/
+extern void pos2ecef(const double *pos, double *r)
+{
+    double sinp=sin(pos[0]),cosp=cos(pos[0]),sinl=sin(pos[1]),cosl=cos(pos[1]);
+    double e2=FE_WGS84*(2.0-FE_WGS84),v=RE_WGS84/sqrt(1.0-e2*sinp*sinp);
 
+    r[0]=(v+pos[2])*cosp*cosl;
+    r[1]=(v+pos[2])*cosp*sinl;
+    r[2]=(v*(1.0-e2)+pos[2])*sinp;
+}
@@ -8,9 +8,48 @@
 *           2016/06/12  added RANGEH to RANGE conversion function
 *           2016/07/11  add decode_satvis function
 *           2016/07/11  modify SNR[] decoding function
+*           2026/10/16  add decode_unicore_buf function for block input
+*           2026/10/16  replace head shift register by sync candidate scan
+*           2026/10/16  accumulate CRC32 while packet bytes are stored
+*           2026/10/16  use parsed options and endian specialized decoders
+*           2026/10/16  decode packets in place, add decode_unicorem function
+*           2026/10/16  add index_unicore and decode_unicore_at functions
+*           2026/10/16  add decode_unicorep function for parallel decoding
+*           2026/10/16  dispatch by message decoder table, add reg_unicore
+*           2026/10/16  add sub_unicore function for message subscription
+*           2026/10/16  check head plausibility, rescan bytes of failed packets
+*           2026/10/16  decode RANGE records by columns, bound obs to MAXOBS
+*           2026/10/16  find obs rows of RANGE records by satellite row map
+*           2026/10/16  map RANGE signals of Galileo and QZSS, skip unmapped records
+*           2026/10/16  decode messages by layouts, add gen_unicore function
+*           2026/10/16  decode RANGE obs to columns by -OBSCOL option
+*           2026/10/16  pair master and heading antenna epochs by -PAIR option
+*           2026/10/16  single differences of antenna pairs by -SDIFF option
+*           2026/10/16  bundle the messages of an epoch by -BUNDLE option
+*           2026/10/16  add event callbacks and decode_unicore_evt function
+*           2026/10/16  skip unchanged ephemerides and ion/utc by fingerprints
+*           2026/10/16  keep history of decoded ephemerides
+*           2026/10/16  select AVX2 RANGE kernels at run time by cpu_avx2()
 *-----------------------------------------------------------------------------*/
 
 #include "decode.h"
+#include <stddef.h>
+
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define RANGE_AVX2              /* AVX2 RANGE kernels selected at run time */
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 /* macros and constants ------------------------------------------------------*/
 #define PI          3.1415926535897932  /* pi */
@@ -19,8 +58,12 @@
 #define SYNC1           0xAA    /* synchronization charater 1 of packet head */
 #define SYNC2           0x44    /* synchronization charater 2 of packet head */
 #define SYNC3           0x12    /* synchronization charater 3 of packet head */
-#define BIG_ENDIAN      1       /* Big-endian platform or data stream */
-#define LITTLE_ENDIAN   2       /* Little-endian platform or data stream */
+#define HEADLEN         28      /* header length of binary messages */
+#define HEADCHK         20      /* head bytes checked before a packet is stored */
+#define MAXWEEK         4095    /* max gps week of a plausible head */
+#define WEEKMS          604800000u /* milliseconds in a week */
+#define BIG_ENDIAN      ENDIAN_BE /* Big-endian platform or data stream */
+#define LITTLE_ENDIAN   ENDIAN_LE /* Little-endian platform or data stream */
 
 #define BD2EPHEM        1047    /* MSG ID: Beidou ephemeris */
 #define BD2IONUTC       2010    /* MSG ID: Beidou ion and utc data */
@@ -33,11 +76,110 @@
 #define PSRPOS          47      /* MSG ID: gsof position message */
 #define SATVIS          48      /* MSG ID: gsof satellite information message */
 
+#define PARCHUNK        (1<<20) /* parallel decoding chunk size (bytes) */
+#define PARBATCH        4       /* parallel decoding chunks per thread in a batch */
+#define SNAPALIGN       8       /* alignment of message snapshots (bytes) */
+#define DEFERRED        (-100)  /* status: user decoder deferred to main thread */
+
+#define RANGELEN        44      /* length of a RANGE observation record */
+#define MAXRANGE        ((MAXRAWLEN-HEADLEN-8)/RANGELEN) /* max RANGE records */
+#define EPHFPOFF        12      /* offset of ephemeris fingerprint (after prn, tow) */
+#define SIGENT(sys, freq, code) /* signal table entry of a tracking status */ \
+    (0x80000000u | ((unsigned int)(sys) << 16) | ((freq) << 8) | (code))
+
 static const double ura_eph[]={ /* ura values (ref [3] 20.3.3.3.1.1) */
     2.4,3.4,4.85,6.85,9.65,13.65,24.0,48.0,96.0,192.0,384.0,768.0,1536.0,
     3072.0,6144.0,0.0
 };
 
+/* Parallel decoding types: --------------------------------------------------*/
+typedef struct {        /* decoded message snapshot */
+    int status;         /* decode status */
+    int size;           /* snapshot size with the following data (bytes) */
+    long long pos;      /* file offset after the message (bytes) */
+    gtime_t time;       /* message time */
+    int week;           /* header week number */
+    double seconds;     /* header seconds in gps week */
+    int msgid;          /* header message id */
+    int tbase;          /* time base */
+    int ephsat;         /* sat number of update ephemeris */
+    unsigned int crc;   /* fingerprint of ephemeris or ion/utc message */
+    unsigned char antno;/* antenna number */
+    char msgtype[32];   /* message type (raw->outtype) */
+    union {             /* outputs of the message type, only this is saved */
+        int nobs;       /* number of obs, obs.data[] follows the snapshot */
+        struct {        /* frame of a deferred user decoder */
+            long long offset;
+            int len;
+        } frame;
+        eph_t eph;      /* ephemeris */
+        struct {        /* ion/utc parameters of the system of msgid */
+            double utc[4], ion[8];
+            int leaps;
+        } ionutc;
+        gsof_pos_t pos; /* gsof position */
+        gsof_vel_t vel; /* gsof velocity */
+        gsof_att_t att; /* gsof attitude */
+        gsof_sat_t sat; /* gsof satellites */
+    } u;
+} rawsnap_t;
+
+typedef struct {        /* parallel decoding chunk */
+    long long start;    /* offset of the first frame (bytes) */
+    long long next;     /* offset of the first frame of the next chunk (bytes) */
+    long long end;      /* offset where decoding stopped, >= next (bytes) */
+    unsigned char *snap;/* message snapshots */
+    size_t n, nmax;     /* size of snapshots used/allocated (bytes) */
+    int stat;           /* status (0:ok,-1:memory allocation error) */
+} rawchunk_t;
+
+typedef struct {        /* parallel decoding thread pool */
+    const rawfile_t *file; /* memory-mapped raw data file */
+    rawchunk_t *chunk;  /* chunks of the batch */
+    int nchunk;         /* number of chunks of the batch */
+    int next;           /* next chunk to decode */
+    lock_t lock;        /* lock of next */
+} rawpool_t;
+
+typedef struct {        /* parallel decoding thread */
+    thread_t thread;    /* thread handle */
+    int run;            /* thread started (0:no,1:yes) */
+    raw_t *raw;         /* receiver raw data control of the thread */
+    rawpool_t *pool;    /* thread pool */
+    int flen;           /* length of the last deferred frame */
+} rawthrd_t;
+
+/* RANGE decoding types: -----------------------------------------------------*/
+typedef struct {        /* RANGE observation records by columns */
+    int prn[MAXRANGE];          /* satellite prn */
+    double psr[MAXRANGE];       /* pseudorange (m) */
+    double adr[MAXRANGE];       /* carrier phase (cycle), sign inverted */
+    float dopp[MAXRANGE];       /* doppler (Hz) */
+    int snr[MAXRANGE];          /* signal strength floor(cno*4) (0.25 dB-Hz) */
+    unsigned int stat[MAXRANGE]; /* channel tracking status */
+    unsigned int sig[MAXRANGE]; /* signal of tracking status (SIGENT,0:none) */
+} rangecol_t;
+
+/* Message layout types: -----------------------------------------------------*/
+typedef struct {        /* ephemeris message */
+    eph_t eph;          /* ephemeris */
+    int prn;            /* system prn */
+    int tow;            /* time of 1st subframe in gps week (s) */
+    unsigned int toe;   /* ephemeris reference time (s) */
+    int toc;            /* reference time of clock parameters (s) */
+    double ura;         /* sv accuracy (m^2) */
+} ephmsg_t;
+
+typedef struct {        /* ion/utc message */
+    double ion[8];      /* iono model parameters {a0,a1,a2,a3,b0,b1,b2,b3} */
+    double utc[4];      /* utc parameters {A0,A1,tot,wn} */
+    unsigned int wnlsf; /* week of new leap second */
+    unsigned int dn;    /* day of week of new leap second (0-6, 0:sunday) */
+    int leaps;          /* leap seconds before new leap second (s) */
+    int leapsf;         /* leap seconds after new leap second (s) */
+    unsigned int dtutc; /* difference to utc */
+} ionmsg_t;
+
 /* Data conversion macros: ---------------------------------------------------*/
 #define I1(p) (*((char*)(p)))          /* One byte signed integer */
 #define U1(p) (*((unsigned char*)(p))) /* One byte unsigned integer */
@@ -48,30 +190,342 @@ static const double ura_eph[]={ /* ura values (ref [3] 20.3.3.3.1.1) */
 #define R4(p,e) read_r4(p,e)           /* IEEE S_FLOAT floating point number */
 #define R8(p,e) read_r8(p,e)           /* IEEE T_FLOAT floating point number */
 
-/* Internal structure definitions. -------------------------------------------*/
-typedef union {unsigned short u2; unsigned char c[2];} ENDIAN_TEST;
+/* Field encoders and lengths by the conversion macro of the field type */
+#define I2_PUT(p,v,e) write_u2(p,(unsigned short)(short)(v),e)
+#define U2_PUT(p,v,e) write_u2(p,(unsigned short)(v),e)
+#define I4_PUT(p,v,e) write_u4(p,(unsigned int)(int)(v),e)
+#define U4_PUT(p,v,e) write_u4(p,(unsigned int)(v),e)
+#define R4_PUT(p,v,e) write_r4(p,(float)(v),e)
+#define R8_PUT(p,v,e) write_r8(p,(double)(v),e)
+#define I2_LEN  2
+#define U2_LEN  2
+#define I4_LEN  4
+#define U4_LEN  4
+#define R4_LEN  4
+#define R8_LEN  8
+
+/* Byte order of the execution platform */
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) || \
+    defined(__BIG_ENDIAN__)
+#define HOST_ENDIAN     BIG_ENDIAN
+#else
+#define HOST_ENDIAN     LITTLE_ENDIAN
+#endif
+
+/* Byte swap and forced inlining */
+#if defined(__GNUC__)
+#define BSWAP16(x)  __builtin_bswap16(x)
+#define BSWAP32(x)  __builtin_bswap32(x)
+#define BSWAP64(x)  __builtin_bswap64(x)
+#define INLINE      __inline__ __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define BSWAP16(x)  _byteswap_ushort(x)
+#define BSWAP32(x)  _byteswap_ulong(x)
+#define BSWAP64(x)  _byteswap_uint64(x)
+#define INLINE      __forceinline
+#else
+#define BSWAP16(x)  ((unsigned short)(((x)>>8)|((x)<<8)))
+#define BSWAP32(x)  ((((x)&0xFFu)<<24)|(((x)&0xFF00u)<<8)|(((x)>>8)&0xFF00u)|((x)>>24))
+#define BSWAP64(x)  (((unsigned long long)BSWAP32((unsigned int)(x))<<32)| \
+                     BSWAP32((unsigned int)((x)>>32)))
+#define INLINE
+#endif
+
+/* Generate <func>_le() and <func>_be() instances of a message decoder with
+ * the endianness fixed, so the field reads carry no endian test. */
+#define ENDIAN_VARIANTS(func) \
+    static int func##_le(raw_t *raw, const unsigned char *buff) \
+        {return func(raw, buff, LITTLE_ENDIAN);} \
+    static int func##_be(raw_t *raw, const unsigned char *buff) \
+        {return func(raw, buff, BIG_ENDIAN);}
+
+/* Message decoder table entry of a built-in decoder */
+#define MSGENT(id, func) {id, func##_le, func##_be, NULL, NULL, 0}
+
+/* Size of batched event data rounded up to keep the data aligned */
+#define EVTSIZE(n)  (((size_t)(n) + 15) & ~(size_t)15)
+
+/* Slot of a message id in the message decoder table */
+#define MSGHASH(id) ((((unsigned int)(id) * 2654435761u) >> 16) & (NMSGTBL-1))
+
+/* Index of the lowest set bit (x != 0) */
+#if defined(__GNUC__)
+#define ctz32(x) ((unsigned int)__builtin_ctz(x))
+#elif defined(_MSC_VER)
+static __inline unsigned int ctz32(unsigned int x)
+{
+    unsigned long i; _BitScanForward(&i, x); return (unsigned int)i;
+}
+#else
+static unsigned int ctz32(unsigned int x)
+{
+    unsigned int i = 0; while (!(x & 1)) {x >>= 1; i++;} return i;
+}
+#endif
 
 /* Internal private function forward declarations (in alphabetical order):----*/
 static int sync_packet(raw_t *raw, unsigned char data);
+static size_t scan_sync(const unsigned char *buff, size_t n);
+static int check_head(raw_t *raw, const unsigned char *buff);
+static void resync_head(raw_t *raw);
+static int packet_len(raw_t *raw, const unsigned char *buff);
+static void start_packet(raw_t *raw);
+static void store_packet(raw_t *raw, const unsigned char *buff, int n);
+static int decode_packet(raw_t *raw, const unsigned char *buff);
+static int decode_block(raw_t *raw, const unsigned char *buff, size_t n,
+                        size_t *consumed);
+static int rescan_packet(raw_t *raw);
+static long long next_frame(raw_t *raw, const unsigned char *buff, long long i,
+                            long long n, int *len);
 static void clear_message_buffer(raw_t *raw);
-static short read_i2(unsigned char *p, int endian);
-static int read_i4(unsigned char *p, int endian);
-static float read_r4(unsigned char *p, int endian);
-static double read_r8(unsigned char *p, int endian);
-static unsigned short read_u2(unsigned char *p, int endian);
-static unsigned int read_u4(unsigned char *p, int endian);
-static int decode_bd2ephem(raw_t *raw, int endian);
-static int decode_gpsephem(raw_t *raw, int endian);
-static int decode_bd2ionutc(raw_t *raw, int endian);
-static int decode_gpsionutc(raw_t *raw, int endian);
-static int decode_range(raw_t *raw, int endian);
-static int decode_rangeh(raw_t *raw, int endian);
-static int decode_attitude(raw_t *raw, int endian);
-static int decode_position(raw_t *raw, int endian);
-static int decode_velocity(raw_t *raw, int endian);
-static int decode_satvis(raw_t *raw, int endian);
-static int rangeh2range(raw_t *raw, FILE *fp);
+static INLINE short read_i2(const unsigned char *p, int endian);
+static INLINE int read_i4(const unsigned char *p, int endian);
+static INLINE float read_r4(const unsigned char *p, int endian);
+static INLINE double read_r8(const unsigned char *p, int endian);
+static INLINE unsigned short read_u2(const unsigned char *p, int endian);
+static INLINE unsigned int read_u4(const unsigned char *p, int endian);
+static INLINE void write_r4(unsigned char *p, float f, int endian);
+static INLINE void write_r8(unsigned char *p, double d, int endian);
+static INLINE void write_u2(unsigned char *p, unsigned short u, int endian);
+static INLINE void write_u4(unsigned char *p, unsigned int u, int endian);
+static INLINE int decode_bd2ephem(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_gpsephem(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_bd2ionutc(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_gpsionutc(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_range(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_rangeh(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_attitude(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_position(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_velocity(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE int decode_satvis(raw_t *raw, const unsigned char *buff,
+                              int endian);
+static INLINE void range_cols(rangecol_t *col, const unsigned char *p, int n,
+                              int endian);
+static INLINE void range_sigs(rangecol_t *col, int n);
+#ifdef RANGE_AVX2
+static int range_cols_avx2(rangecol_t *col, const unsigned char *p, int n,
+                           int e);
+static int range_sigs_avx2(rangecol_t *col, int n);
+#endif
+static INLINE int range_row(raw_t *raw, const rangecol_t *col, int i);
+static INLINE int same_msg(const raw_t *raw, unsigned int *fp,
+                           const unsigned char *p, int len);
+static int assemble_msg(raw_t *raw, int status);
+static int pair_obs(raw_t *raw, int status);
+static int bundle_msg(raw_t *raw, int status);
+static void learn_bundle(bundle_t *bnd, unsigned int bits, int week, int ms);
+static unsigned int bundle_set(const bundle_t *bnd, int ms);
+static void out_bundle(raw_t *raw, bndep_t *ep);
+static int emit_status(raw_t *raw, int status);
+static int emit_evt(raw_t *raw, int type, int status, int ant, gtime_t time,
+                    const void *data);
+static void drop_pair(obspair_t *pair, int a, int n, int ndrop);
+
+/* Message layouts: F(member, offset, type, scale) ---------------------------
+ * A field of the message data at offset (bytes) is read by the conversion
+ * macro type, multiplied by scale and stored to member of the layout target.
+ * MSG_CODEC(name, layout, target type, message data length) generates
+ *   <name>_len          message data length, checked to hold all fields
+ *   get_<name>(t, p, e) decode the message data at p to the target t
+ *   put_<name>(p, t, e) encode the target t to the message data at p
+ * with every field read or written in place, so a new message of a fixed
+ * layout only needs its layout and the conversion of the target. */
+#define LAYOUT_GET(m, off, type, scale) t->m = type(p+(off), e)*(scale);
+#define LAYOUT_PUT(m, off, type, scale) type##_PUT(p+(off), t->m/(scale), e);
+#define LAYOUT_END(m, off, type, scale) unsigned char f##off[(off)+type##_LEN];
+#define MSG_CODEC(name, LAYOUT, T, len) \
+    enum {name##_len = (len)}; \
+    typedef char name##_fits[sizeof(union {LAYOUT(LAYOUT_END)}) <= (len) ? 1 : -1]; \
+    static INLINE void get_##name(T *t, const unsigned char *p, int e) \
+        {LAYOUT(LAYOUT_GET)} \
+    static INLINE void put_##name(unsigned char *p, const T *t, int e) \
+        {LAYOUT(LAYOUT_PUT)}
+
+/* Orbit parameters shared by the GPS and BDS ephemerides (ephmsg_t) */
+#define EPHORB_LAYOUT(F) \
+    F(eph.A,     40, R8, 1)     /* Semi-major axis (m) */ \
+    F(eph.deln,  48, R8, 1)     /* Correction of mean angle velocity (rad/s) */ \
+    F(eph.M0,    56, R8, 1)     /* Mean anomaly at reference time (rad) */ \
+    F(eph.e,     64, R8, 1)     /* Eccentricity */ \
+    F(eph.omg,   72, R8, 1)     /* Argument of perigee (rad) */ \
+    F(eph.cuc,   80, R8, 1)     /* Cosine correction to argument of latitude (rad) */ \
+    F(eph.cus,   88, R8, 1)     /* Sine correction to argument of latitude (rad) */ \
+    F(eph.crc,   96, R8, 1)     /* Cosine correction to orbit radius (m) */ \
+    F(eph.crs,  104, R8, 1)     /* Sine correction to orbit radius (m) */ \
+    F(eph.cic,  112, R8, 1)     /* Cosine correction to angle of inclination (rad) */ \
+    F(eph.cis,  120, R8, 1)     /* Sine correction to angle of inclination (rad) */ \
+    F(eph.i0,   128, R8, 1)     /* Inclination angle at reference time (rad) */ \
+    F(eph.idot, 136, R8, 1)     /* Rate of inclination angle (rad/s) */ \
+    F(eph.OMG0, 144, R8, 1)     /* Longitude of ascending node (rad) */ \
+    F(eph.OMGd, 152, R8, 1)     /* Rate of longitude of ascending node (rad/s) */
+
+/* GPSEPHEM: GPS ephemeris (ephmsg_t) */
+#define GPSEPHEM_LAYOUT(F) \
+    F(prn,        0, U4, 1)     /* System PRN */ \
+    F(tow,        4, R8, 1)     /* Time (s) of 1st subframe in week */ \
+    F(eph.svh,   12, U4, 1)     /* SV health */ \
+    F(eph.iode,  20, U4, 1)     /* Ephemeris #2 age = GPS IODE1 */ \
+    F(eph.week,  24, U4, 1)     /* GPS week */ \
+    F(toe,       32, R8, 1)     /* Ephemeris reference time (s) */ \
+    EPHORB_LAYOUT(F) \
+    F(eph.aodc, 160, U4, 1)     /* Age of data, clock */ \
+    F(toc,      164, R8, 1)     /* Reference time of clock parameters (s) */ \
+    F(eph.tgd[0],172,R8, 1)     /* Equipment group delay differential (s) */ \
+    F(eph.f0,   180, R8, 1)     /* Satellite clock bias (s) */ \
+    F(eph.f1,   188, R8, 1)     /* Satellite clock rate (s/s) */ \
+    F(eph.f2,   196, R8, 1)     /* Satellite clock acceleration (s/s^2) */ \
+    F(ura,      216, R8, 1)     /* SV accuracy (m^2) */
+
+/* BD2EPHEM: BDS ephemeris (ephmsg_t) */
+#define BD2EPHEM_LAYOUT(F) \
+    F(prn,        0, U4, 1)     /* System PRN */ \
+    F(tow,        4, R8, 1)     /* Time (s) of 1st subframe in week */ \
+    F(eph.svh,   12, U4, 1)     /* SV health */ \
+    F(eph.aode,  16, U4, 1)     /* AODE age of data, ephemeris */ \
+    F(eph.week,  24, U4, 1)     /* GPS week */ \
+    F(toe,       32, R8, 1)     /* Ephemeris reference time (s) */ \
+    EPHORB_LAYOUT(F) \
+    F(eph.aodc, 160, U4, 1)     /* Age of data, clock */ \
+    F(toc,      164, R8, 1)     /* Reference time of clock parameters (s) */ \
+    F(eph.tgd[0],172,R8, 1)     /* Equipment group delay differential of B1 (s) */ \
+    F(eph.tgd[1],180,R8, 1)     /* Equipment group delay differential of B2 (s) */ \
+    F(eph.f0,   188, R8, 1)     /* Satellite clock bias (s) */ \
+    F(eph.f1,   196, R8, 1)     /* Satellite clock rate (s/s) */ \
+    F(eph.f2,   204, R8, 1)     /* Satellite clock acceleration (s/s^2) */ \
+    F(ura,      224, R8, 1)     /* SV accuracy (m^2) */
+
+/* IONUTC, BD2IONUTC: GPS and BDS ion/utc parameters (ionmsg_t) */
+#define IONUTC_LAYOUT(F) \
+    F(ion[0],     0, R8, 1)     /* a0 */ \
+    F(ion[1],     8, R8, 1)     /* a1 */ \
+    F(ion[2],    16, R8, 1)     /* a2 */ \
+    F(ion[3],    24, R8, 1)     /* a3 */ \
+    F(ion[4],    32, R8, 1)     /* b0 */ \
+    F(ion[5],    40, R8, 1)     /* b1 */ \
+    F(ion[6],    48, R8, 1)     /* b2 */ \
+    F(ion[7],    56, R8, 1)     /* b3 */ \
+    F(utc[3],    64, U4, 1)     /* Reference week of utc parameters */ \
+    F(utc[2],    68, U4, 1)     /* Reference time of utc parameters (s) */ \
+    F(utc[0],    72, R8, 1)     /* A0 */ \
+    F(utc[1],    80, R8, 1)     /* A1 */ \
+    F(wnlsf,     88, U4, 1)     /* Week of new leap second */ \
+    F(dn,        92, U4, 1)     /* Day of new leap second */ \
+    F(leaps,     96, I4, 1)     /* Leap seconds before new leap second */ \
+    F(leapsf,   100, I4, 1)     /* Leap seconds after new leap second */ \
+    F(dtutc,    104, U4, 1)     /* Difference to utc */
+
+/* HEADING: gsof attitude (gsof_att_t) */
+#define HEADING_LAYOUT(F) \
+    F(length,     8, R4, 1)     /* Baseline length (m) */ \
+    F(heading,   12, R4, 1)     /* Heading (deg) */ \
+    F(pitch,     16, R4, 1)     /* Pitch (deg) */ \
+    F(heading_sig,24,R4, 1)     /* Heading stdev (deg) */ \
+    F(pitch_sig, 28, R4, 1)     /* Pitch stdev (deg) */
+
+/* PSRPOS: gsof position (gsof_pos_t) */
+#define PSRPOS_LAYOUT(F) \
+    F(lat,        8, R8, 1)     /* Latitude (deg) */ \
+    F(lon,       16, R8, 1)     /* Longitude (deg) */ \
+    F(hgt,       24, R8, 1)     /* Height above sea level (m) */ \
+    F(undulation,32, R4, 1)     /* Geoid undulation (m) */
+
+/* PSRVEL: gsof velocity (gsof_vel_t) */
+#define PSRVEL_LAYOUT(F) \
+    F(hspd,      16, R8, 1)     /* Horizontal speed (m/s) */ \
+    F(heading,   24, R8, 1)     /* Direction relative to true north (deg) */ \
+    F(vspd,      32, R8, 1)     /* Vertical speed (m/s) */
+
+MSG_CODEC(gpsephem, GPSEPHEM_LAYOUT, ephmsg_t,   224)
+MSG_CODEC(bd2ephem, BD2EPHEM_LAYOUT, ephmsg_t,   232)
+MSG_CODEC(ionutc,   IONUTC_LAYOUT,   ionmsg_t,   108)
+MSG_CODEC(heading,  HEADING_LAYOUT,  gsof_att_t,  44)
+MSG_CODEC(psrpos,   PSRPOS_LAYOUT,   gsof_pos_t,  72)
+MSG_CODEC(psrvel,   PSRVEL_LAYOUT,   gsof_vel_t,  44)
+
+/* Little-endian and big-endian instances of the message decoders. */
+ENDIAN_VARIANTS(decode_bd2ephem)
+ENDIAN_VARIANTS(decode_gpsephem)
+ENDIAN_VARIANTS(decode_bd2ionutc)
+ENDIAN_VARIANTS(decode_gpsionutc)
+ENDIAN_VARIANTS(decode_range)
+ENDIAN_VARIANTS(decode_rangeh)
+ENDIAN_VARIANTS(decode_attitude)
+ENDIAN_VARIANTS(decode_position)
+ENDIAN_VARIANTS(decode_velocity)
+ENDIAN_VARIANTS(decode_satvis)
+
+/* Built-in message decoders */
+static const msgent_t msgtbl0[] = {
+    MSGENT(BD2EPHEM,  decode_bd2ephem),
+    MSGENT(GPSEPHEM,  decode_gpsephem),
+    MSGENT(BD2IONUTC, decode_bd2ionutc),
+    MSGENT(IONUTC,    decode_gpsionutc),
+    MSGENT(RANGE,     decode_range),
+    MSGENT(RANGEH,    decode_rangeh),
+    MSGENT(HEADING,   decode_attitude),
+    MSGENT(PSRPOS,    decode_position),
+    MSGENT(PSRVEL,    decode_velocity),
+    MSGENT(SATVIS,    decode_satvis)
+};
+
+/* Satellite system, frequency and code by the system and signal fields of
+ * the RANGE channel tracking status (0: signal not mapped) */
+static const unsigned int sigtbl[8][32] = {
+    {   /* 0: GPS */
+        [ 0] = SIGENT(SYS_GPS, 0, CODE_L1C),    /* L1 C/A */
+        [ 5] = SIGENT(SYS_GPS, 1, CODE_L2P),    /* L2 P */
+        [ 9] = SIGENT(SYS_GPS, 1, CODE_L2P),    /* L2 P(Y) semi-codeless */
+        [14] = SIGENT(SYS_GPS, 2, CODE_L5Q),    /* L5 Q */
+        [17] = SIGENT(SYS_GPS, 1, CODE_L2C)     /* L2C */
+    },
+    {   /* 1: GLONASS */
+        [ 0] = SIGENT(SYS_GLO, 0, CODE_L1C),    /* L1 C/A */
+        [ 1] = SIGENT(SYS_GLO, 1, CODE_L2C),    /* L2 C/A */
+        [ 5] = SIGENT(SYS_GLO, 1, CODE_L2P)     /* L2 P */
+    },
+    {0},                                        /* 2: SBAS */
+    {   /* 3: Galileo */
+        [ 1] = SIGENT(SYS_GAL, 0, CODE_L1B),    /* E1B */
+        [ 2] = SIGENT(SYS_GAL, 0, CODE_L1C),    /* E1C */
+        [12] = SIGENT(SYS_GAL, 2, CODE_L5Q),    /* E5a Q */
+        [17] = SIGENT(SYS_GAL, 1, CODE_L7Q)     /* E5b Q */
+    },
+    {   /* 4: BDS */
+        [ 0] = SIGENT(SYS_BDS, 0, CODE_L1I),    /* B1I */
+        [17] = SIGENT(SYS_BDS, 1, CODE_L7I),    /* B2I */
+        [21] = SIGENT(SYS_BDS, 2, CODE_L6I)     /* B3I */
+    },
+    {   /* 5: QZSS */
+        [ 0] = SIGENT(SYS_QZS, 0, CODE_L1C),    /* L1 C/A */
+        [14] = SIGENT(SYS_QZS, 2, CODE_L5Q),    /* L5 Q */
+        [17] = SIGENT(SYS_QZS, 1, CODE_L2C)     /* L2C */
+    },
+    {0}, {0}
+};
+static int rangeh2range(raw_t *raw, const unsigned char *buff, FILE *fp);
 static int uraindex(double value);
+static void decode_chunk(rawthrd_t *thrd, rawchunk_t *chunk);
+static int save_snap(rawchunk_t *chunk, const rawthrd_t *thrd, int status,
+                     long long pos);
+static int load_snap(raw_t *raw, const rawsnap_t *snap);
+static int defer_msg(raw_t *raw, const unsigned char *buff, void *arg);
+static void init_msgtbl(raw_t *raw);
+static INLINE msgent_t *find_msg(raw_t *raw, int msgid);
+static msgent_t *slot_msg(raw_t *raw, int msgid);
+#ifdef WIN32
+static DWORD WINAPI decode_thread(void *arg);
+#else
+static void *decode_thread(void *arg);
+#endif
 
 
 /* RANGEH to RANGE conversion variants ---------------------------------------*/
@@ -107,164 +561,324 @@ static int uraindex(double value);
 |    3: input sbas message
 |    9: input ion/utc parameter
 |   11: input observation data (heading antenna)
+|   12: input observation data pair (raw->obs: master, raw->obuf: heading
+|       antenna) with the -PAIR option
 |   21: input gsof position data
 |   22: input gsof velocity data
 |   23: input gsof attitude data
 |   24: input gsof satellite data
+|   31: input epoch bundle (raw->bnd.mask: messages in raw->obs, raw->obuf,
+|       raw->gsof) with the -BUNDLE option
 |
 | Design Issues:
 |
 */
 extern int decode_unicore(raw_t *raw, unsigned char data)
 {
-    int status = 0;
-    unsigned short msg_id = 0;
+    int status;
+
+    /* Queue the byte behind the bytes of a failed packet to rescan or
+     * behind a bundle to output */
+    if (raw->nscan > 0 || raw->bnd.pend)
+    {
+        if (raw->nscan == 0) raw->iscan = 0;
+        if (raw->iscan + raw->nscan >= MAXRAWLEN)
+        {
+            memmove(raw->buff, raw->buff+raw->iscan, raw->nscan);
+            raw->iscan = 0;
+        }
+        raw->buff[raw->iscan + raw->nscan++] = data;
+        return decode_unicore_buf(raw, NULL, 0, NULL);
+    }
 
     /* If no current packet */
-    if (raw->nbyte == 0)
+    if (raw->len == 0)
     {
         /* Find something that looks like a packet */
         if(sync_packet(raw, data))
         {
-            raw->len   = raw->buff[3] + 
-                U2(raw->buff+8, strstr(raw->opt, "-LE")?LITTLE_ENDIAN:BIG_ENDIAN) +
-                4;              /* header + message + CRC32 */
-            raw->nbyte = 10;    /* we now have 10 bytes in message buffer */  
+            start_packet(raw);
         }
         /* Continue reading the rest of the packet from the stream. */
         return 0;
     }
 
     /* Store the next byte of the packet */
-    raw->buff[raw->nbyte++] = data;
+    store_packet(raw, &data, 1);
 
     /* Keep storing bytes into the current packet 
      * until we have what we think are all of them. */    
     if (raw->nbyte < raw->len)
         return (0);
 
-    /* At this point we think we have an entire packet.
-     * Check the packet checksum CRC32 */
-    if (crc32(raw->buff, raw->len-4) != 
-        U4(raw->buff+raw->len-4, strstr(raw->opt, "-LE")?LITTLE_ENDIAN:BIG_ENDIAN) )
-    {
-        clear_message_buffer(raw);
-        return 0;
-    }
-
-    /* Get time tag(gpst) from record header */
-    raw->week = U2(raw->buff+14, strstr(raw->opt, "-LE")?LITTLE_ENDIAN:BIG_ENDIAN);
-    raw->seconds = (double)U4(raw->buff+16, 
-        strstr(raw->opt, "-LE")?LITTLE_ENDIAN:BIG_ENDIAN)/1000.0;
-    raw->time = gpst2time(raw->week, raw->seconds);
-    raw->tbase= 0;
+    /* Rescan the bytes of a packet failing the CRC32 check at once */
+    if (!(status = decode_packet(raw, raw->buff)) && raw->nscan > 0)
+        status = decode_unicore_buf(raw, NULL, 0, NULL);
 
-    /* Get message id */
-    msg_id = U2(raw->buff+4, strstr(raw->opt, "-LE")?LITTLE_ENDIAN:BIG_ENDIAN);
+    return (status);
+}
 
-    /* Add to output message type id */
-    if (raw->outtype) {
-        sprintf(raw->msgtype,"unicore %6d (%4d)", msg_id, raw->len);
-    }
+/*
+| Function: decode_unicore_buf
+| Purpose:  Decode an UnicoreComm mesasge from a block of raw data stream
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw      = Receiver raw data control structure [Input]
+|   buff     = stream data block                   [Input]
+|   n        = number of bytes in stream data block [Input]
+|   consumed = number of bytes consumed (NULL: no output) [Output]
+|
+| Implicit Inputs:
+|
+|   raw->buff[]
+|   raw->len
+|   raw->nbyte
+|
+| Implicit outputs:
+|
+|   raw->buff[]
+|   raw->len
+|   raw->nbyte
+|
+| Return Value:
+|
+|   same as decode_unicore()
+|
+| Design Issues:
+|
+|   Decoding stops after the first message resolved, so the caller should call
+|   again with buff+*consumed until the whole block is consumed. The state
+|   between calls is kept in raw, so a block may end anywhere inside a packet
+|   and the results are the same as feeding the bytes to decode_unicore().
+|   Bytes between packets are skipped by searching the next sync character.
+|   A packet lying entirely in the block is checked and decoded in place,
+|   only a packet split across blocks is copied to raw->buff[]. The bytes of
+|   a packet failing the CRC32 check are rescanned for the next packet head,
+|   before the block if the packet was copied to raw->buff[]. An epoch
+|   bundle pending output (see bundle_msg()) is output first, no byte is
+|   consumed then.
+*/
+extern int decode_unicore_buf(raw_t *raw, const unsigned char *buff, size_t n,
+                              size_t *consumed)
+{
+    size_t i = 0, m;
+    int status = 0;
 
-    /* If this is a Beidou ephemeris packet, then process it immediately. */
-    if (msg_id == BD2EPHEM)
+    /* Output the bundle completed behind the bundle output last */
+    if (raw->bnd.pend)
     {
-        status = decode_bd2ephem( raw, strstr(raw->opt,"-LE") ?
-                                        LITTLE_ENDIAN : BIG_ENDIAN );
-        clear_message_buffer(raw);
-        return (status);
+        raw->bnd.pend = 0;
+        out_bundle(raw, raw->bnd.ep + raw->bnd.acc);
+        if (consumed) *consumed = 0;
+        return (31);
     }
-
-    /* If this is a GPS ephemeris packet */
-    if (msg_id == GPSEPHEM)
+    while (!status)
     {
-        status = decode_gpsephem(raw, strstr(raw->opt, "-LE") ? 
-                                        LITTLE_ENDIAN : BIG_ENDIAN );
-        clear_message_buffer(raw);
-        return (status);
-    }
+        /* Rescan the bytes of a failed packet before the block */
+        if (raw->nscan > 0)
+        {
+            status = rescan_packet(raw);
+            continue;
+        }
+        if (i >= n) break;
 
-    /* If this is a Beidou ion/utc packet */
-    if (msg_id == BD2IONUTC)
-    {
-        status = decode_bd2ionutc(raw, strstr(raw->opt, "-LE") ? 
-                                        LITTLE_ENDIAN : BIG_ENDIAN );
-        clear_message_buffer(raw);
-        return (status);
+        status = decode_block(raw, buff+i, n-i, &m);
+        i += m;
     }
+    if (consumed) *consumed = i;
 
-    /* If this is a GPS ion/utc packet */
-    if (msg_id == IONUTC)
-    {
-        status = decode_gpsionutc(raw, strstr(raw->opt, "-LE") ? 
-                                        LITTLE_ENDIAN : BIG_ENDIAN );
-        clear_message_buffer(raw);
-        return (status);
-    }
+    return (status);
+}
 
-    /* If this is a raw observation packet */
-    if (msg_id == RANGE)
-    {
-        status = decode_range(raw, strstr(raw->opt, "-LE") ? 
-                                        LITTLE_ENDIAN : BIG_ENDIAN );
-        clear_message_buffer(raw);
-        return (status);
-    }
+/*
+| Function: decode_block
+| Purpose:  Decode an UnicoreComm mesasge from a block up to a failed packet
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw      = Receiver raw data control structure [Input]
+|   buff     = stream data block                   [Input]
+|   n        = number of bytes in stream data block [Input]
+|   consumed = number of bytes consumed            [Output]
+|
+| Implicit Inputs:
+|
+|   raw->buff[]
+|   raw->len
+|   raw->nbyte
+|
+| Implicit outputs:
+|
+|   raw->buff[]
+|   raw->len
+|   raw->nbyte
+|   raw->iscan
+|   raw->nscan
+|
+| Return Value:
+|
+|   same as decode_unicore()
+|
+| Design Issues:
+|
+|   Stops after the first message resolved or after a stored packet failing
+|   the CRC32 check, whose bytes are then set to be rescanned. A packet in
+|   the block failing the check is rescanned in place from its second byte.
+|   Buff may point to the bytes to rescan in raw->buff[]. Bytes are stored
+|   only below the byte read, so they are moved with memmove().
+*/
+static int decode_block(raw_t *raw, const unsigned char *buff, size_t n,
+                        size_t *consumed)
+{
+    const msgent_t *ent;
+    size_t i = 0, m;
+    int len, status = 0;
 
-    /* If this is a raw observation packet of heading antenna */
-    if (msg_id == RANGEH)
+    while (i < n && !status && !raw->nscan)
     {
-#ifdef RANGEH_RANGE
-        extern FILE *rangehb;
-        rangeh2range(raw, rangehb);
-#endif
-        status = decode_rangeh(raw, strstr(raw->opt, "-LE") ? 
-                                        LITTLE_ENDIAN : BIG_ENDIAN );
+        /* If no current packet and no partial packet head */
+        if (raw->nbyte == 0)
+        {
+            /* Jump to the next sync characters */
+            i += scan_sync(buff+i, n-i);
+            if (i >= n) break;
 
-        clear_message_buffer(raw);
-        return (status);
-    }
+            /* Partial packet head at the end of block, keep it */
+            if (n-i < HEADCHK)
+            {
+                memmove(raw->buff, buff+i, n-i);
+                raw->nbyte = (int)(n-i);
+                i = n;
+                break;
+            }
+            if (!check_head(raw, buff+i))
+            {
+                i++;
+                continue;
+            }
+            if (!(len = packet_len(raw, buff+i)))
+            {
+                i += HEADCHK;
+                continue;
+            }
+            /* Decode the packet in place if it is all in the block */
+            if ((size_t)len <= n-i)
+            {
+                /* Skip a packet without decoder or subscription */
+                ent = find_msg(raw, U2(buff+i+4, raw->cfg.endian));
+                if (!ent && !raw->cfg.chkskip)
+                {
+                    i += len;
+                    continue;
+                }
+                /* Rescan a packet failing the CRC32 check from the next byte */
+                raw->crc = crc32_update(0, buff+i, len-4);
+                if (raw->crc != U4(buff+i+len-4, raw->cfg.endian))
+                {
+                    trace(2, "unicore: crc error, len=%d.\n", len);
+                    i++;
+                    continue;
+                }
+                if (!ent)
+                {
+                    i += len;
+                    continue;
+                }
+                raw->len = len;
+                status = decode_packet(raw, buff+i);
+                i += len;
+                continue;
+            }
+            memmove(raw->buff, buff+i, HEADCHK);
+            raw->nbyte = HEADCHK;
+            start_packet(raw);
+            i += HEADCHK;
+            continue;
+        }
 
-    /* If this is a attitude packet */
-    if(msg_id == HEADING)
-    {
-        status = decode_attitude(raw, strstr(raw->opt, "-LE") ?
-                                        LITTLE_ENDIAN : BIG_ENDIAN);
-        clear_message_buffer(raw);
-        return (status);
-    }
+        /* Complete the partial packet head */
+        if (raw->len == 0)
+        {
+            if (sync_packet(raw, buff[i++]))
+            {
+                start_packet(raw);
+            }
+            continue;
+        }
 
-    /* If this is a position packet */
-    if(msg_id == PSRPOS)
-    {
-        status = decode_position(raw, strstr(raw->opt, "-LE") ?
-                                        LITTLE_ENDIAN : BIG_ENDIAN);
-        clear_message_buffer(raw);
-        return (status);
+        /* Store the rest of the packet at once */
+        m = (size_t)(raw->len - raw->nbyte);
+        if (m > n-i) m = n-i;
+        store_packet(raw, buff+i, (int)m);
+        i += m;
+
+        if (raw->nbyte < raw->len) break;
+
+        status = decode_packet(raw, raw->buff);
     }
+    *consumed = i;
+
+    return (status);
+}
 
-    /* If this is a velocity packet */
-    if(msg_id == PSRVEL)
+/*
+| Function: rescan_packet
+| Purpose:  Decode the bytes of a packet which failed the CRC32 check
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw = Receiver raw data control structure [Input]
+|
+| Implicit Inputs:
+|
+|   raw->buff[]
+|   raw->iscan
+|   raw->nscan
+|
+| Implicit outputs:
+|
+|   raw->buff[]
+|   raw->iscan
+|   raw->nscan
+|
+| Return Value:
+|
+|   same as decode_unicore()
+|
+| Design Issues:
+|
+|   The bytes after the false head are decoded as a block, so a real packet
+|   inside a false one is found as if the head had been rejected at once.
+|   They are always the last bytes read from the stream. The bytes left after
+|   a message resolved or after another failed packet are kept to rescan.
+*/
+static int rescan_packet(raw_t *raw)
+{
+    size_t m;
+    int i = raw->iscan, n = raw->nscan, status;
+
+    raw->nscan = 0;
+    status = decode_block(raw, raw->buff+i, (size_t)n, &m);
+    i += (int)m;
+    n -= (int)m;
+    if (n <= 0) return (status);
+
+    /* Keep the rest behind the bytes of a failed packet */
+    if (raw->nscan > 0)
     {
-        status = decode_velocity(raw, strstr(raw->opt, "-LE") ?
-                                        LITTLE_ENDIAN : BIG_ENDIAN);
-        clear_message_buffer(raw);
-        return (status);
+        memmove(raw->buff+raw->iscan+raw->nscan, raw->buff+i, n);
+        raw->nscan += n;
     }
-
-    /* If this is a satellite vision packet */
-    if(msg_id == SATVIS)
+    else
     {
-        status = decode_satvis(raw, strstr(raw->opt, "-LE") ?
-                                        LITTLE_ENDIAN : BIG_ENDIAN);
-        clear_message_buffer(raw);
-        return(status);
+        raw->iscan = i;
+        raw->nscan = n;
     }
-
-    /* Other packets, ignored */
-    clear_message_buffer(raw);
-    return (0);
+    return (status);
 }
 
 /*
@@ -311,128 +925,139 @@ extern int decode_unicoref(raw_t *raw, FILE *fp)
 
     while (1)
     {
-        if ((data = fgetc(fp)) == EOF) return (-2);
+        if ((data = fgetc(fp)) == EOF)
+        {
+            /* Rescan the bytes of a failed packet at the end of file */
+            while (raw->nscan > 0 || raw->bnd.pend)
+            {
+                if ((status = decode_unicore_buf(raw, NULL, 0, NULL)))
+                    return (status);
+            }
+            return (-2);
+        }
         if ((status = decode_unicore(raw, (unsigned char) data))) return (status);
                         /* if there is no message resolved, then continue the loop */
     }
 }
 
 /*
-| Function: sync_packet
-| Purpose:  Synchronize the raw data stream to the start of a series of unicore packets 
+| Function: decode_unicorem
+| Purpose:  Decode an UnicoreComm mesasge from a memory-mapped file
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
 |   Raw  = Receiver raw data control structure [Input]
-|   Data = Next character in raw data stream   [Input]
+|   File = Memory-mapped raw data file         [Input]
 |
 | Implicit Inputs:
 |
-|   Raw->buff[0-9]
+|   File->data[]
+|   File->size
+|   File->pos
 |
-| Implicit Outputs:
+| Implicit outputs:
 |
-|   Raw=>buff[0-9]
+|   File->pos
 |
 | Return Value:
 |
-|   TRUE  = Start of packet sequence tentatively found
-|   FALSE = Not found, keep reading data bytes from the stream
+| -2: end of file
+| -1...31: same as above
 |
 | Design Issues:
 |
+|   The mapping is handed to decode_unicore_buf() as one block, so every
+|   packet is checked and decoded in place. The results are the same as
+|   decode_unicoref() on the same file.
 */
-static int sync_packet(raw_t *raw, unsigned char data)
+extern int decode_unicorem(raw_t *raw, rawfile_t *file)
 {
-    unsigned char type;
-    unsigned char head_len;     /* header length */
-    unsigned short msg_id;      /* message id */
-    unsigned short msg_len;     /* message data length */
-
-    raw->buff[0] = raw->buff[1];	/* delete pbuff[0] and move forward the next 10 char */
-    raw->buff[1] = raw->buff[2];
-    raw->buff[2] = raw->buff[3];
-    raw->buff[3] = raw->buff[4];
-    raw->buff[4] = raw->buff[5];
-    raw->buff[5] = raw->buff[6];
-    raw->buff[6] = raw->buff[7];
-    raw->buff[7] = raw->buff[8];
-    raw->buff[8] = raw->buff[9];
-    raw->buff[9] = data;			/* add the new entered char 'data' to the end of message head */
-
-    msg_id = U2(raw->buff+4, strstr(raw->opt, "-LE")?LITTLE_ENDIAN:BIG_ENDIAN);
-
-    msg_len= U2(raw->buff+8, strstr(raw->opt, "-LE")?LITTLE_ENDIAN:BIG_ENDIAN);
+    size_t n;
+    int status;
 
-    /*
-    | Byte 0-2 = synchronize character: 0xAA 0x44 0x12
-    | Byte 4-5 = message id which must be the one we're intrested in.
-    | Byte 8-9 = message length which must be non-zero for any message we're intrested in.
-    */
-    return ( (raw->buff[0] == SYNC1 && raw->buff[1] == SYNC2 && raw->buff[2] == SYNC3)
-//              && (msg_id == BD2EPHEM || msg_id == BD2IONUTC || msg_id == GPSEPHEM || 
-//                  msg_id == IONUTC || msg_id == RANGE || msg_id == RANGEH) 
-              &&  msg_len != 0);
+    while (file->pos < file->size || raw->nscan > 0 || raw->bnd.pend)
+    {
+        status = decode_unicore_buf(raw, file->data+file->pos,
+                                    (size_t)(file->size-file->pos), &n);
+        file->pos += n;
+        if (status) return (status);
+    }
+    return (-2);
 }
 
 /*
-| Function: read_i2
-| Purpose:  Fetch & convert a signed two byte integer (short)
-| Authors:  Daniel A. Cook
+| Function: index_unicore
+| Purpose:  Build the frame index of a memory-mapped UnicoreComm file
+| Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   P      = Input pointer        [Input]
-|   Endian = Endianness indicator [Input]
+|   Raw   = Receiver raw data control structure [Input]
+|   File  = Memory-mapped raw data file         [Input]
+|   Index = Raw data frame index                [Output]
 |
 | Implicit Inputs:
 |
-|   <none>
+|   Raw->cfg
+|   File->data[]
+|   File->size
 |
-| Implicit Outputs:
+| Implicit outputs:
 |
 |   <none>
 |
 | Return Value:
 |
-|   Fetched and converted signed two byte integer (short)
+|   Number of frames in the index, -1: memory allocation error
 |
-| Design issues:
+| Design Issues:
 |
-|   The data is fetched one byte at a time so as to handle data that
-|   is not naturally aligned. It is then converted from the input
-|   endianness to our execution platform endianness.
+|   Only the head (sync, message id, length, week and milliseconds) of each
+|   frame is parsed, the message data is not decoded. Frames are synchronized
+|   and CRC32 checked the same way as decode_unicore_buf(), so the index holds
+|   exactly the frames a decoding pass from the file start would accept,
+|   unless the pass skips frames unchecked by the -FASTSKIP option. The
+|   records are appended to Index, which is usually empty on input.
 */
-static short read_i2(unsigned char *p, int endian) 
+extern int index_unicore(raw_t *raw, const rawfile_t *file, rawindex_t *index)
 {
-    union I2 {short i2; unsigned char c[2];} u;
-    ENDIAN_TEST et;
+    const unsigned char *buff = file->data;
+    long long i, n = file->size;
+    rawidx_t rec;
+    int len, e;
 
-    memcpy(&u.i2, p, sizeof(u.i2));
+    index->size = file->size;
 
-    et.u2 = 0; et.c[0] = 1;  
-    if ((et.u2 == 1) && (endian != LITTLE_ENDIAN))
+    for (i = 0; (i = next_frame(raw, buff, i, n, &len)) < n; i += len)
     {
-        unsigned char t;
-        t = u.c[0]; u.c[0] = u.c[1]; u.c[1] = t;
+        e = raw->cfg.endian;
+        rec.offset = i;
+        rec.len    = len;
+        rec.msgid  = U2(buff+i+4, e);
+        rec.week   = U2(buff+i+14, e);
+        rec.ms     = U4(buff+i+16, e);
+        if (!add_rawindex(index, &rec)) return (-1);
     }
-    return (u.i2);
+    return (index->n);
 }
 
 /*
-| Function: read_i4
-| Purpose:  Fetch & convert a four byte signed integer (int)
-| Authors:  Daniel A. Cook
+| Function: next_frame
+| Purpose:  Search the next frame with a valid CRC32 in a block
+| Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   P      = Input pointer        [Input]
-|   Endian = Endianness indicator [Input]
+|   Raw  = Receiver raw data control structure [Input]
+|   Buff = Stream data block                   [Input]
+|   I    = Offset to start the search from     [Input]
+|   N    = Number of bytes in stream data block [Input]
+|   Len  = Frame length                        [Output]
 |
 | Implicit Inputs:
 |
-|   <none>
+|   Raw->cfg
 |
 | Implicit Outputs:
 |
@@ -440,75 +1065,590 @@ static short read_i2(unsigned char *p, int endian)
 |
 | Return Value:
 |
-|   Fetched and converted four byte signed integer (int)
+|   Offset of the frame head, N if no complete frame is found
 |
-| Design issues:
+| Design Issues:
 |
-|   The data is fetched one byte at a time so as to handle data that is not
-|   naturally aligned. It is then converted from the input endianness to our
-|   execution platform endianness.
+|   Heads are synchronized as decode_unicore_buf() does, and a frame failing
+|   the CRC32 is rescanned from its second byte, so starting from a position
+|   where the decoder holds no partial packet the same frames are found.
 */
-static int read_i4(unsigned char *p, int endian)
+static long long next_frame(raw_t *raw, const unsigned char *buff, long long i,
+                            long long n, int *len)
 {
-    union i4 {int i4; unsigned char c[4];} u;
-    ENDIAN_TEST et;
+    while (i < n)
+    {
+        /* Jump to the next sync characters */
+        i += scan_sync(buff+i, (size_t)(n-i));
+        if (n-i < HEADCHK) break;
+
+        if (!check_head(raw, buff+i))
+        {
+            i++;
+            continue;
+        }
+        if (!(*len = packet_len(raw, buff+i)))
+        {
+            i += HEADCHK;
+            continue;
+        }
+        /* Frame truncated at the end of block */
+        if (*len > n-i) break;
 
-    memcpy(&u.i4, p, sizeof(u.i4));
+        if (crc32_update(0, buff+i, *len-4) == 
+            U4(buff+i+*len-4, raw->cfg.endian))
+            return (i);
 
-    et.u2 = 0; et.c[0] = 1;  
-    if ((et.u2 == 1) && (endian != LITTLE_ENDIAN))
-    {
-        unsigned char t;
-        t = u.c[0]; u.c[0] = u.c[3]; u.c[3] = t;
-        t = u.c[1]; u.c[1] = u.c[2]; u.c[2] = t;
-    }   
-    return (u.i4);
+        i++;
+    }
+    return (n);
 }
 
 /*
-| Function: read_r4
-| Purpose:  Fetch & convert an IEEE S_FLOAT (float)
-| Authors:  Daniel A. Cook
+| Function: decode_unicore_at
+| Purpose:  Decode the UnicoreComm frame of an index record
+| Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   P      = Input pointer        [Input]
-|   Endian = Endianness indicator [Input]
+|   Raw  = Receiver raw data control structure [Input]
+|   File = Memory-mapped raw data file         [Input]
+|   Rec  = Frame index record                  [Input]
 |
 | Implicit Inputs:
 |
-|   <none>
+|   File->data[]
+|   File->size
 |
-| Implicit Outputs:
+| Implicit outputs:
 |
-|   <none>
+|   File->pos
 |
 | Return Value:
 |
-|   Fetched and converted IEEE S_FLOAT (float)
+| -2: frame out of file
+| -1...31: same as above
 |
-| Design issues:
+| Design Issues:
 |
-|   The data is fetched one byte at a time so as to handle data that is not
-|   naturally aligned. It is then converted from the input endianness to our
-|   execution platform endianness.
+|   A partial packet left in Raw is dropped. File->pos is set after the frame,
+|   so decoding may continue from there with decode_unicorem().
 */
-static float read_r4(unsigned char *p, int endian)
+extern int decode_unicore_at(raw_t *raw, rawfile_t *file, const rawidx_t *rec)
 {
-    union R4 {float f; unsigned int u4;} u; 
-    u.u4 = U4(p, endian);
-    return (u.f);
+    size_t n;
+    int status;
+
+    if (rec->offset < 0 || rec->len <= 0 ||
+        rec->offset > file->size - rec->len)
+        return (-2);
+
+    clear_message_buffer(raw);
+    file->pos = rec->offset;
+
+    status = decode_unicore_buf(raw, file->data+rec->offset, (size_t)rec->len,
+                                &n);
+    file->pos += n;
+    return (status);
 }
 
 /*
-| Function: read_r8
-| Purpose:  Fetch & convert an IEEE T_FLOAT (double)
-| Authors:  Daniel A. Cook
+| Function: decode_unicorep
+| Purpose:  Decode an UnicoreComm memory-mapped file on multiple threads
+| Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   P      = Input pointer        [Input]
-|   Endian = Endianness indicator [Input]
+|   Raw     = Receiver raw data control structure [Input]
+|   File    = Memory-mapped raw data file         [Input]
+|   Nthread = Number of decoding threads          [Input]
+|   Cb      = Message callback                    [Input]
+|   Arg     = Argument of message callback        [Input]
+|
+| Implicit Inputs:
+|
+|   File->data[]
+|   File->size
+|   File->pos
+|
+| Implicit outputs:
+|
+|   Raw->obs, Raw->nav, Raw->gsof, Raw->time, ...
+|   File->pos
+|
+| Return Value:
+|
+|   Number of messages passed to Cb, -1: memory allocation error
+|
+| Design Issues:
+|
+|   The file is cut into chunks of PARCHUNK bytes at the next frame with a
+|   valid CRC32. A batch of chunks is decoded by the threads, each with its
+|   own raw_t, and every message resolved is saved as a snapshot of the raw
+|   outputs it changed. The snapshots are then loaded into Raw in file order
+|   and Cb(Raw, status, Arg) is called for each, so Raw->nav carries the
+|   ephemerides and ion/utc parameters forward as in a sequential decoding
+|   and Cb sees exactly what decode_unicorem() would return. A non-zero
+|   return of Cb stops the decoding after that message. User decoders of
+|   reg_unicore() are not run on the threads, their frames are decoded by
+|   this thread with Raw in file order, so are the messages paired and
+|   bundled by the -PAIR and -BUNDLE options.
+|   A chunk runs past its end until the decoder holds no partial packet nor
+|   bytes to rescan. If
+|   that point is not where the next chunk started (a false packet head
+|   spans the cut), the next chunk is decoded again from there. The memory
+|   is bounded by PARBATCH chunks per thread. If a thread cannot be started,
+|   the chunks are decoded by the others and by this thread.
+*/
+extern int decode_unicorep(raw_t *raw, rawfile_t *file, int nthread, rawcb_t cb,
+                           void *arg)
+{
+    rawthrd_t thrd[MAXRAWTHRD];
+    rawpool_t pool;
+    rawchunk_t *chunk;
+    const rawsnap_t *snap;
+    const unsigned char *p;
+    rawidx_t rec;
+    long long pos;
+    size_t n;
+    int i, j, k, len, nchunk, status, nmsg = 0, stop = 0;
+
+    trace(3, "decode_unicorep: nthread=%d\n", nthread);
+
+    if (nthread < 1) nthread = 1;
+    if (nthread > MAXRAWTHRD) nthread = MAXRAWTHRD;
+    nchunk = nthread * PARBATCH;
+
+    if (!raw->cfg.init) setopt_raw(raw, raw->opt);
+    if (!raw->msgtbl.init) init_msgtbl(raw);
+
+    /* Finish a packet in progress so that the chunks start clean */
+    while ((raw->nscan > 0 || raw->bnd.pend ||
+            (file->pos < file->size && raw->nbyte > 0)) && !stop)
+    {
+        n = raw->nscan > 0 ? 0 :
+            raw->len > 0 ? (size_t)(raw->len - raw->nbyte) : 1;
+        status = decode_unicore_buf(raw, file->data+file->pos, n, &n);
+        file->pos += n;
+        if (status) {nmsg++; stop = cb(raw, status, arg);}
+    }
+    if (stop || file->pos >= file->size) return (nmsg);
+
+    if (!(chunk = (rawchunk_t *)calloc(nchunk, sizeof(rawchunk_t)))) {
+        return (-1);
+    }
+    for (i = 0; i < nthread; i++)
+    {
+        if (!(thrd[i].raw = (raw_t *)calloc(1, sizeof(raw_t))) ||
+            !init_raw(thrd[i].raw))
+        {
+            free(thrd[i].raw);
+            nthread = i;
+            status = -1;
+            goto done;
+        }
+        setopt_raw(thrd[i].raw, raw->opt);
+        thrd[i].raw->cfg.pairtt = 0.0; /* paired and bundled in file order */
+        thrd[i].raw->cfg.bundle = 0;
+        thrd[i].raw->cfg.ephall = 1;   /* unchanged ones skipped in file order */
+        thrd[i].raw->outtype = raw->outtype;
+        thrd[i].pool = &pool;
+
+        /* User decoders are deferred to this thread to run in file order */
+        thrd[i].raw->msgtbl = raw->msgtbl;
+        for (j = 0; j < NMSGTBL; j++)
+        {
+            if (!thrd[i].raw->msgtbl.ent[j].func) continue;
+            thrd[i].raw->msgtbl.ent[j].func = defer_msg;
+            thrd[i].raw->msgtbl.ent[j].arg  = thrd+i;
+        }
+    }
+    pool.file = file;
+    pool.chunk = chunk;
+    initlock(&pool.lock);
+
+    while (file->pos < file->size && !stop)
+    {
+        /* Cut the batch at frames with valid CRC32 */
+        pos = file->pos;
+        for (k = 0; k < nchunk; k++)
+        {
+            chunk[k].start = pos;
+            pos += PARCHUNK;
+            pos = pos < file->size ? 
+                next_frame(raw, file->data, pos, file->size, &len) : file->size;
+            chunk[k].next = pos;
+        }
+        pool.nchunk = nchunk;
+        pool.next = 0;
+
+        /* Decode the chunks on the threads */
+        for (i = 0; i < nthread; i++)
+        {
+#ifdef WIN32
+            thrd[i].thread = CreateThread(NULL, 0, decode_thread, thrd+i, 0, NULL);
+            thrd[i].run = thrd[i].thread != NULL;
+#else
+            thrd[i].run = !pthread_create(&thrd[i].thread, NULL, decode_thread,
+                                          thrd+i);
+#endif
+            if (!thrd[i].run) trace(2, "unicore: thread create error.\n");
+        }
+        /* The chunks left by threads not started are decoded by this one */
+        for (i = 0; i < nthread; i++)
+        {
+            if (thrd[i].run) continue;
+            decode_thread(thrd+i);
+            break;
+        }
+        for (i = 0; i < nthread; i++)
+        {
+            if (!thrd[i].run) continue;
+#ifdef WIN32
+            WaitForSingleObject(thrd[i].thread, INFINITE);
+            CloseHandle(thrd[i].thread);
+#else
+            pthread_join(thrd[i].thread, NULL);
+#endif
+        }
+
+        /* Load the snapshots in file order */
+        for (k = 0; k < nchunk && !stop; k++)
+        {
+            if (chunk[k].start != file->pos)
+            {
+                chunk[k].start = file->pos;
+                decode_chunk(thrd, chunk+k);
+            }
+            if (chunk[k].stat < 0)
+            {
+                status = -1;
+                goto done;
+            }
+            for (p = chunk[k].snap; p < chunk[k].snap+chunk[k].n && !stop; )
+            {
+                snap = (const rawsnap_t *)p;
+                p += snap->size;
+                file->pos = snap->pos;
+
+                /* Run a deferred user decoder on the frame */
+                if ((status = snap->status) == DEFERRED)
+                {
+                    rec.offset = snap->u.frame.offset;
+                    rec.len = snap->u.frame.len;
+                    if (!(status = decode_unicore_at(raw, file, &rec))) continue;
+                }
+                else
+                {
+                    if (!(status = load_snap(raw, snap))) continue;
+                    if (status > 0 && !(status = assemble_msg(raw, status))) continue;
+                }
+
+                nmsg++;
+                stop = cb(raw, status, arg);
+
+                /* Output the bundle completed behind the bundle output */
+                if (!stop && raw->bnd.pend)
+                {
+                    status = decode_unicore_buf(raw, NULL, 0, NULL);
+                    nmsg++;
+                    stop = cb(raw, status, arg);
+                }
+            }
+            if (!stop) file->pos = chunk[k].end;
+        }
+    }
+    status = 0;
+
+done:
+    for (i = 0; i < nthread; i++)
+    {
+        free_raw(thrd[i].raw);
+        free(thrd[i].raw);
+    }
+    for (k = 0; k < nchunk; k++) free(chunk[k].snap);
+    free(chunk);
+
+    return (status < 0 ? -1 : nmsg);
+}
+
+/*
+| Function: decode_unicore_evt
+| Purpose:  Decode a block of raw data stream and pass the messages as events
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw  = Receiver raw data control structure [Input/Output]
+|   Buff = stream data block                   [Input]
+|   N    = number of bytes in stream data block [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->evts
+|
+| Implicit outputs:
+|
+|   Raw->evts
+|
+| Return Value:
+|
+|   Number of messages decoded, -1: memory allocation error of the batch
+|
+| Design Issues:
+|
+|   All the block is decoded by decode_unicore_buf(), every message resolved
+|   is passed to the event callbacks of on_unicore() at once, the data are
+|   valid in the call only. With a batch callback of onbatch_unicore() the
+|   events are also copied into Raw->evts and passed in one call after the
+|   block, the data are valid until the next call of this function. A
+|   packet split across blocks is completed by the next block as with
+|   decode_unicore_buf().
+*/
+extern int decode_unicore_evt(raw_t *raw, const unsigned char *buff, size_t n)
+{
+    rawevts_t *evts = &raw->evts;
+    obs_t *obs;
+    size_t i = 0, m, off;
+    int j, status, nmsg = 0, stat = 0;
+
+    while (i < n || raw->nscan > 0 || raw->bnd.pend)
+    {
+        status = decode_unicore_buf(raw, buff+i, n-i, &m);
+        i += m;
+        if (!status) break;
+        nmsg++;
+        if (emit_status(raw, status) < 0) stat = -1;
+    }
+    if (!evts->batch || evts->n <= 0) return (stat < 0 ? -1 : nmsg);
+
+    /* Point the batched events to the data, they were kept as offsets */
+    for (j = 0; j < evts->n; j++)
+    {
+        off = evts->off[j];
+        evts->evt[j].data = evts->data + off;
+        if (evts->evt[j].type != EVTOBS) continue;
+        obs = (obs_t *)(evts->data + off);
+        obs->data = (obsd_t *)(evts->data + off + EVTSIZE(sizeof(obs_t)));
+    }
+    evts->batch(evts->evt, evts->n, evts->barg);
+    evts->n = 0;
+    evts->ndata = 0;
+
+    return (stat < 0 ? -1 : nmsg);
+}
+
+/*
+| Function: emit_status
+| Purpose:  Pass the outputs of a status of the decode functions as events
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw    = Receiver raw data control structure [Input/Output]
+|   Status = Status of the decode functions      [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->obs, Raw->obuf, Raw->nav, Raw->gsof, Raw->bnd, ...
+|
+| Implicit outputs:
+|
+|   Raw->evts
+|
+| Return Value:
+|
+|   0: ok, -1: memory allocation error of the batch
+|
+| Design Issues:
+|
+|   A pair (status 12) is passed as two observation events, a bundle
+|   (status 31) as an event per message in it. Statuses without outputs
+|   (-1, 0, user decoders) pass no event.
+*/
+static int emit_status(raw_t *raw, int status)
+{
+    evtion_t ion;
+    unsigned int mask = raw->bnd.mask;
+    int stat = 0;
+
+    switch (status)
+    {
+        case 1:
+        case 11:
+            if (raw->cfg.obscol) obscol2obs(&raw->ocol, &raw->obs);
+            return emit_evt(raw, EVTOBS, status, status == 11, raw->time, &raw->obs);
+        case 12:
+            mask = BNDRANGE | BNDRANGEH;
+            break;
+        case 2:
+            if (raw->ephsat <= 0) return (0);
+            return emit_evt(raw, EVTEPH, status, 0, raw->time,
+                            raw->nav.eph + raw->ephsat - 1);
+        case 9:
+            memset(&ion, 0, sizeof(ion));
+            ion.sys = raw->msgid == BD2IONUTC ? SYS_BDS : SYS_GPS;
+            memcpy(ion.ion, ion.sys == SYS_BDS ? raw->nav.ion_bds : raw->nav.ion_gps,
+                   sizeof(ion.ion));
+            memcpy(ion.utc, ion.sys == SYS_BDS ? raw->nav.utc_bds : raw->nav.utc_gps,
+                   sizeof(ion.utc));
+            ion.leaps = raw->nav.leaps;
+            return emit_evt(raw, EVTION, status, 0, raw->time, &ion);
+        case 21: return emit_evt(raw, EVTPOS, status, 0, raw->time, &raw->gsof.pos);
+        case 22: return emit_evt(raw, EVTVEL, status, 0, raw->time, &raw->gsof.vel);
+        case 23: return emit_evt(raw, EVTATT, status, 0, raw->time, &raw->gsof.att);
+        case 24: return emit_evt(raw, EVTSAT, status, 0, raw->time, &raw->gsof.sat);
+        case 31:
+            break;
+        default:
+            return (0);
+    }
+    /* Pair and bundle of messages at raw->tobs */
+    if ((mask & BNDRANGE) &&
+        emit_evt(raw, EVTOBS, status, 0, raw->tobs, &raw->obs) < 0) stat = -1;
+    if ((mask & BNDRANGEH) &&
+        emit_evt(raw, EVTOBS, status, 1, raw->tobs, &raw->obuf) < 0) stat = -1;
+    if (status == 12) return (stat);
+    if ((mask & BNDPOS) &&
+        emit_evt(raw, EVTPOS, status, 0, raw->tobs, &raw->gsof.pos) < 0) stat = -1;
+    if ((mask & BNDVEL) &&
+        emit_evt(raw, EVTVEL, status, 0, raw->tobs, &raw->gsof.vel) < 0) stat = -1;
+    if ((mask & BNDATT) &&
+        emit_evt(raw, EVTATT, status, 0, raw->tobs, &raw->gsof.att) < 0) stat = -1;
+    if ((mask & BNDSAT) &&
+        emit_evt(raw, EVTSAT, status, 0, raw->tobs, &raw->gsof.sat) < 0) stat = -1;
+    return (stat);
+}
+
+/*
+| Function: emit_evt
+| Purpose:  Pass an event to the callback and add it to the batch
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw    = Receiver raw data control structure [Input/Output]
+|   Type   = Event type (EVT???)                 [Input]
+|   Status = Status of the decode functions      [Input]
+|   Ant    = Antenna of observation data         [Input]
+|   Time   = Message time                        [Input]
+|   Data   = Decoded data of the type            [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->msgid
+|
+| Implicit outputs:
+|
+|   Raw->evts
+|
+| Return Value:
+|
+|   0: ok, -1: memory allocation error of the batch
+|
+| Design Issues:
+|
+|   The batched data are copied at offsets in one growing block, only the
+|   records in use of observation data and gsof satellites are copied.
+*/
+static int emit_evt(raw_t *raw, int type, int status, int ant, gtime_t time,
+                    const void *data)
+{
+    rawevts_t *evts = &raw->evts;
+    rawevt_t evt, *e;
+    const obs_t *obs;
+    const gsof_sat_t *sat;
+    unsigned char *p;
+    size_t size, nmax, *off;
+
+    evt.type   = type;
+    evt.status = status;
+    evt.msgid  = raw->msgid;
+    evt.ant    = ant;
+    evt.time   = time;
+    evt.data   = data;
+
+    if (evts->func[type]) evts->func[type](&evt, evts->arg[type]);
+    if (!evts->batch) return (0);
+
+    switch (type)
+    {
+        case EVTOBS:
+            obs = (const obs_t *)data;
+            size = EVTSIZE(sizeof(obs_t)) + sizeof(obsd_t) * obs->n;
+            break;
+        case EVTSAT:
+            sat = (const gsof_sat_t *)data;
+            size = offsetof(gsof_sat_t, data) + sizeof(gsof_satd_t) *
+                   (sat->num < MAXOBS ? sat->num : MAXOBS);
+            break;
+        case EVTEPH: size = sizeof(eph_t);      break;
+        case EVTION: size = sizeof(evtion_t);   break;
+        case EVTATT: size = sizeof(gsof_att_t); break;
+        case EVTPOS: size = sizeof(gsof_pos_t); break;
+        default:     size = sizeof(gsof_vel_t); break;
+    }
+    /* Grow the batch */
+    if (evts->n >= evts->nmax)
+    {
+        nmax = evts->nmax <= 0 ? 64 : 2 * (size_t)evts->nmax;
+        if (!(e = (rawevt_t *)realloc(evts->evt, sizeof(rawevt_t) * nmax)))
+        {
+            trace(1, "unicore: event batch memory allocation error.\n");
+            return (-1);
+        }
+        evts->evt  = e;
+        if (!(off = (size_t *)realloc(evts->off, sizeof(size_t) * nmax)))
+        {
+            trace(1, "unicore: event batch memory allocation error.\n");
+            return (-1);
+        }
+        evts->off  = off;
+        evts->nmax = (int)nmax;
+    }
+    if (evts->ndata + EVTSIZE(size) > evts->ndmax)
+    {
+        nmax = evts->ndmax <= 0 ? 65536 : 2 * evts->ndmax;
+        while (nmax < evts->ndata + EVTSIZE(size)) nmax *= 2;
+        if (!(p = (unsigned char *)realloc(evts->data, nmax)))
+        {
+            trace(1, "unicore: event batch memory allocation error.\n");
+            return (-1);
+        }
+        evts->data  = p;
+        evts->ndmax = nmax;
+    }
+    /* Copy the data, kept at their offset until the batch is passed */
+    p = evts->data + evts->ndata;
+    if (type == EVTOBS)
+    {
+        memcpy(p, data, sizeof(obs_t));
+        ((obs_t *)p)->nmax = obs->n;
+        memcpy(p + EVTSIZE(sizeof(obs_t)), obs->data, sizeof(obsd_t) * obs->n);
+    }
+    else if (type == EVTSAT)
+    {
+        memcpy(p, data, size);
+        ((gsof_sat_t *)p)->num = sat->num < MAXOBS ? sat->num : MAXOBS;
+    }
+    else memcpy(p, data, size);
+
+    evt.data = NULL;
+    evts->off[evts->n] = evts->ndata;
+    evts->evt[evts->n++] = evt;
+    evts->ndata += EVTSIZE(size);
+
+    return (0);
+}
+
+/*
+| Function: decode_thread
+| Purpose:  Decode chunks of a batch until none is left
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Arg = Parallel decoding thread (rawthrd_t) [Input]
 |
 | Implicit Inputs:
 |
@@ -520,86 +1660,111 @@ static float read_r4(unsigned char *p, int endian)
 |
 | Return Value:
 |
-|   Fetched and converted IEEE T_FLOAT (double)
+|   0
 |
-| Design issues:
+| Design Issues:
 |
-|   The data is fetched one byte at a time so as to handle data that is not
-|   naturally aligned. It is then converted from the input endianness to our
-|   execution platform endianness.
 */
-static double read_r8(unsigned char *p, int endian)
+#ifdef WIN32
+static DWORD WINAPI decode_thread(void *arg)
+#else
+static void *decode_thread(void *arg)
+#endif
 {
-    ENDIAN_TEST et;
-    union R8 {double d; unsigned char c[8];} u;
+    rawthrd_t *thrd = (rawthrd_t *)arg;
+    rawpool_t *pool = thrd->pool;
+    int k;
 
-    memcpy(&u.d, p, sizeof(u.d));
- 
-    et.u2 = 0; et.c[0] = 1;  
-    if ((et.u2 == 1) && (endian != LITTLE_ENDIAN))
+    while (1)
     {
-        unsigned char t;
-        t = u.c[0]; u.c[0] = u.c[7]; u.c[7] = t;
-        t = u.c[1]; u.c[1] = u.c[6]; u.c[6] = t;
-        t = u.c[2]; u.c[2] = u.c[5]; u.c[5] = t;
-        t = u.c[3]; u.c[3] = u.c[4]; u.c[4] = t;  
+        lock(&pool->lock);
+        k = pool->next++;
+        unlock(&pool->lock);
+
+        if (k >= pool->nchunk) break;
+
+        decode_chunk(thrd, pool->chunk+k);
     }
-    return (u.d);
+    return 0;
 }
 
 /*
-| Function: read_u2
-| Purpose:  Fetch & convert an unsigned twe byte integer (unsigned short)
-| Authors:  Daniel A. Cook
+| Function: decode_chunk
+| Purpose:  Decode a chunk of a file and save snapshots of the messages
+| Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   P      = Input pointer        [Input]
-|   Endian = Endianness indicator [Input]
+|   Thrd  = Parallel decoding thread            [Input]
+|   Chunk = Parallel decoding chunk             [Input]
 |
 | Implicit Inputs:
 |
-|   <none>
+|   Chunk->start
+|   Chunk->next
 |
 | Implicit Outputs:
 |
-|   <none>
+|   Chunk->end
+|   Chunk->snap[]
+|   Chunk->n
+|   Chunk->stat
 |
 | Return Value:
 |
-|   Fetched and converted two byte unsigned integer (unsigned short)
+|   <none>
 |
-| Design issues:
+| Design Issues:
 |
-|   The data is fetched one byte at a time so as to handle data that
-|   is not naturally aligned. It is then converted from the input
-|   endianness to our execution platform endianness.
+|   Decoding goes on past Chunk->next up to the first byte where no partial
+|   packet is held, bytes after Chunk->next are fed one packet (or one head
+|   byte) at a time to find this point exactly. The bytes of a failed packet
+|   are the last bytes read, so a message resolved while they are rescanned
+|   is saved at the file position of the next byte to rescan.
 */
-static unsigned short read_u2(unsigned char *p, int endian)
+static void decode_chunk(rawthrd_t *thrd, rawchunk_t *chunk)
 {
-    ENDIAN_TEST et;
-    union U2 {unsigned short u2; unsigned char c[2];} u;
+    const rawfile_t *file = thrd->pool->file;
+    raw_t *raw = thrd->raw;
+    long long pos = chunk->start;
+    size_t n;
+    int status;
+
+    clear_message_buffer(raw);
+    chunk->n = 0;
+    chunk->stat = 0;
 
-    memcpy(&u.u2, p, sizeof(u.u2)); 
- 
-    et.u2 = 0; et.c[0] = 1;  
-    if ((et.u2 == 1) && (endian != LITTLE_ENDIAN))
+    while (pos < file->size || raw->nscan > 0)
     {
-        unsigned char t;
-        t = u.c[0]; u.c[0] = u.c[1]; u.c[1] = t;
+        if (pos < chunk->next) n = (size_t)(chunk->next - pos);
+        else if (raw->nscan > 0) n = 0;
+        else if (raw->len > 0) n = (size_t)(raw->len - raw->nbyte);
+        else if (raw->nbyte > 0) n = 1;
+        else break;
+
+        status = decode_unicore_buf(raw, file->data+pos, n, &n);
+        pos += n;
+
+        if (status && !save_snap(chunk, thrd, status, pos - raw->nscan))
+        {
+            chunk->stat = -1;
+            break;
+        }
     }
-    return (u.u2);
+    chunk->end = pos;
 }
 
 /*
-| Function: read_u4
-| Purpose:  Fetch & convert a four byte unsigned integer (unsigned int)
-| Authors:  Daniel A. Cook
+| Function: save_snap
+| Purpose:  Save a snapshot of the raw outputs of a decoded message
+| Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   P      = Input pointer        [Input]
-|   Endian = Endianness indicator [Input]
+|   Chunk  = Parallel decoding chunk            [Input/Output]
+|   Thrd   = Parallel decoding thread           [Input]
+|   Status = Decode status of the message       [Input]
+|   Pos    = File offset after the message      [Input]
 |
 | Implicit Inputs:
 |
@@ -611,684 +1776,2885 @@ static unsigned short read_u2(unsigned char *p, int endian)
 |
 | Return Value:
 |
-|   Fetched and converted four byte unsigned integer (unsigned int)
+|   1: ok, 0: memory allocation error
 |
-| Design issues:
+| Design Issues:
 |
-|   The data is fetched one byte at a time so as to handle data that is not
-|   naturally aligned. It is then converted from the input endianness to our
-|   execution platform endianness.
+|   Only the outputs of the message type are saved: the observations, the
+|   updated ephemeris, the ion/utc parameters or the gsof record. For a
+|   deferred user decoder the frame is saved instead.
 */
-static unsigned int read_u4(unsigned char *p, int endian)
+static int save_snap(rawchunk_t *chunk, const rawthrd_t *thrd, int status,
+                     long long pos)
 {
-    ENDIAN_TEST et;
-    union U4 {unsigned int u4; unsigned char c[4];} u;
+    const raw_t *raw = thrd->raw;
+    rawsnap_t *snap;
+    unsigned char *p;
+    size_t size = offsetof(rawsnap_t, u), nmax;
+    int nobs = raw->cfg.obscol ? raw->ocol.n : raw->obs.n;
+
+    if (nobs > MAXOBS) nobs = MAXOBS;
+
+    switch (status)
+    {
+    case DEFERRED: size += sizeof(snap->u.frame); break;
+    case 1: case 11: size += sizeof(int) + sizeof(obsd_t)*nobs; break;
+    case 2:  size += sizeof(eph_t);      break;
+    case 9:  size += sizeof(snap->u.ionutc); break;
+    case 21: size += sizeof(gsof_pos_t); break;
+    case 22: size += sizeof(gsof_vel_t); break;
+    case 23: size += sizeof(gsof_att_t); break;
+    case 24: size += sizeof(gsof_sat_t); break;
+    }
+    size = (size + SNAPALIGN-1) / SNAPALIGN * SNAPALIGN;
+
+    if (chunk->n + size > chunk->nmax)
+    {
+        nmax = chunk->nmax ? chunk->nmax*2 : PARCHUNK;
+        while (nmax < chunk->n + size) nmax *= 2;
+        if (!(p = (unsigned char *)realloc(chunk->snap, nmax))) return (0);
+        chunk->snap = p;
+        chunk->nmax = nmax;
+    }
+    snap = (rawsnap_t *)(chunk->snap + chunk->n);
+    chunk->n += size;
 
-    memcpy(&u.u4, p, sizeof(u.u4));
- 
-    et.u2 = 0; et.c[0] = 1;  
-	
-	/* et.u2 == 1 means host platform is LITTLE_ENDIAN, if stream platform is 
-	 * BIG_ENDIAN, then we need to convert it our host platform.
-	 * This ignores the occasion that host is BIG_ENDIAN while stream is LITTLE_ENDIAN
-	 * by gldong 2016/03/18
-	 */
-    if ((et.u2 == 1) && (endian != LITTLE_ENDIAN)) 
+    snap->status  = status;
+    snap->size    = (int)size;
+    snap->pos     = pos;
+    snap->time    = raw->time;
+    snap->week    = raw->week;
+    snap->seconds = raw->seconds;
+    snap->msgid   = raw->msgid;
+    snap->tbase   = raw->tbase;
+    snap->ephsat  = raw->ephsat;
+    snap->antno   = raw->antno;
+    snap->crc     = 0;
+    snap->msgtype[0] = '\0';
+    if (raw->outtype) {
+        strncpy(snap->msgtype, raw->msgtype, sizeof(snap->msgtype)-1);
+        snap->msgtype[sizeof(snap->msgtype)-1] = '\0';
+    }
+    switch (status)
     {
-        unsigned char t;
-        t = u.c[0]; u.c[0] = u.c[3]; u.c[3] = t;
-        t = u.c[1]; u.c[1] = u.c[2]; u.c[2] = t;
-    }   
-    return (u.u4);
+    case DEFERRED:
+        snap->u.frame.offset = pos - thrd->flen; /* packet ends at pos */
+        snap->u.frame.len = thrd->flen;
+        break;
+    case 1: case 11:
+        /* obs by columns are saved as records */
+        if (raw->cfg.obscol) obscol2obs(&raw->ocol, &thrd->raw->obs);
+        snap->u.nobs = nobs;
+        memcpy((unsigned char *)&snap->u.nobs + sizeof(int), raw->obs.data,
+               sizeof(obsd_t)*nobs);
+        break;
+    case 2:
+        snap->u.eph = raw->nav.eph[raw->ephsat-1];
+        snap->crc = raw->ephcrc[raw->ephsat-1];
+        break;
+    case 9:
+        snap->crc = raw->ioncrc[raw->msgid == BD2IONUTC];
+        if (raw->msgid == BD2IONUTC) {
+            memcpy(snap->u.ionutc.utc, raw->nav.utc_bds, sizeof(raw->nav.utc_bds));
+            memcpy(snap->u.ionutc.ion, raw->nav.ion_bds, sizeof(raw->nav.ion_bds));
+        }
+        else {
+            memcpy(snap->u.ionutc.utc, raw->nav.utc_gps, sizeof(raw->nav.utc_gps));
+            memcpy(snap->u.ionutc.ion, raw->nav.ion_gps, sizeof(raw->nav.ion_gps));
+        }
+        snap->u.ionutc.leaps = raw->nav.leaps;
+        break;
+    case 21: snap->u.pos = raw->gsof.pos; break;
+    case 22: snap->u.vel = raw->gsof.vel; break;
+    case 23: snap->u.att = raw->gsof.att; break;
+    case 24: snap->u.sat = raw->gsof.sat; break;
+    }
+    return (1);
 }
 
 /*
-| Function: clear_message_buffer
-| Purpose:  Clear the packet buffer
+| Function: load_snap
+| Purpose:  Load a snapshot of a decoded message into raw
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
+|   Raw  = Receiver raw data control structure [Output]
+|   Snap = Message snapshot                    [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   <none>
 |
 | Implicit Outputs:
 |
-|   Raw->pbuff[0-9]
-|   Raw->pbyte;
-|   Raw->plen;
+|   Raw->obs, Raw->nav, Raw->ehist, Raw->gsof, Raw->time, ...
+|   Raw->ephcrc[], Raw->ioncrc[]
 |
 | Return Value:
 |
-|   <none>
+|   Status of the message, 0: unchanged ephemeris or ion/utc
 |
-| Design issues:
+| Design Issues:
 |
+|   The threads save every ephemeris and ion/utc message with its
+|   fingerprint, the unchanged ones are skipped here in file order as
+|   decode_bd2ephem() etc. do in serial decoding.
 */
-static void clear_message_buffer(raw_t *raw)
+static int load_snap(raw_t *raw, const rawsnap_t *snap)
+{
+    unsigned int *fp;
+
+    if (snap->status == 2 || snap->status == 9)
+    {
+        fp = snap->status == 2 ? raw->ephcrc + snap->ephsat - 1 :
+             raw->ioncrc + (snap->msgid == BD2IONUTC);
+        if (!raw->cfg.ephall && snap->crc && snap->crc == *fp) return (0);
+        *fp = snap->crc;
+    }
+    raw->time    = snap->time;
+    raw->week    = snap->week;
+    raw->seconds = snap->seconds;
+    raw->msgid   = snap->msgid;
+    raw->tbase   = snap->tbase;
+    raw->ephsat  = snap->ephsat;
+    raw->antno   = snap->antno;
+    if (raw->outtype) strcpy(raw->msgtype, snap->msgtype);
+
+    switch (snap->status)
+    {
+    case 1: case 11:
+        raw->obs.n = snap->u.nobs;
+        memcpy(raw->obs.data, (const unsigned char *)&snap->u.nobs + sizeof(int),
+               sizeof(obsd_t)*snap->u.nobs);
+        if (raw->cfg.obscol)
+        {
+            obs2obscol(&raw->obs, &raw->ocol);
+            raw->ocol.time = snap->time;
+            raw->obs.n = 0;
+        }
+        break;
+    case 2:
+        raw->nav.eph[snap->ephsat-1] = snap->u.eph;
+        add_ephhist(&raw->ehist, &snap->u.eph);
+        break;
+    case 9:
+        if (snap->msgid == BD2IONUTC) {
+            memcpy(raw->nav.utc_bds, snap->u.ionutc.utc, sizeof(raw->nav.utc_bds));
+            memcpy(raw->nav.ion_bds, snap->u.ionutc.ion, sizeof(raw->nav.ion_bds));
+        }
+        else {
+            memcpy(raw->nav.utc_gps, snap->u.ionutc.utc, sizeof(raw->nav.utc_gps));
+            memcpy(raw->nav.ion_gps, snap->u.ionutc.ion, sizeof(raw->nav.ion_gps));
+        }
+        raw->nav.leaps = snap->u.ionutc.leaps;
+        break;
+    case 21: raw->gsof.pos = snap->u.pos; break;
+    case 22: raw->gsof.vel = snap->u.vel; break;
+    case 23: raw->gsof.att = snap->u.att; break;
+    case 24: raw->gsof.sat = snap->u.sat; break;
+    }
+    return (snap->status);
+}
+
+/*
+| Function: defer_msg
+| Purpose:  Stand-in of a user decoder on a parallel decoding thread
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw  = Receiver raw data control structure [Input]
+|   Buff = Packet data                         [Input]
+|   Arg  = Parallel decoding thread (rawthrd_t) [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->len
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   DEFERRED
+|
+| Design Issues:
+|
+|   Buff may be raw->buff for a packet split by the chunk end, so only the
+|   length is kept, the packet is located from where decoding stopped.
+*/
+static int defer_msg(raw_t *raw, const unsigned char *buff, void *arg)
+{
+    (void)buff;
+    ((rawthrd_t *)arg)->flen = raw->len;
+    return (DEFERRED);
+}
+
+/*
+| Function: reg_unicore
+| Purpose:  Register a user decoder of a message id
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw   = Receiver raw data control structure [Input/Output]
+|   Msgid = Message id                          [Input]
+|   Func  = User decoder                        [Input]
+|   Arg   = Argument passed to Func             [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->msgtbl
+|
+| Return Value:
+|
+|   1: ok, 0: invalid message id or decoder table full
+|
+| Design Issues:
+|
+|   The user decoder replaces a built-in decoder of the same id. It is
+|   called as Func(Raw, Buff, Arg) for each packet of the id passing the
+|   CRC32 check, with Buff pointing to the packet head, Raw->len the packet
+|   length and Raw->time/week/seconds/msgid set from the head. Its return
+|   value is returned by the decode functions, 0 for no message. Packets of
+|   ids without decoder are CRC32 checked but not decoded.
+*/
+extern int reg_unicore(raw_t *raw, int msgid, msgfunc_t func, void *arg)
+{
+    msgent_t *ent;
+
+    trace(3, "reg_unicore: msgid=%d\n", msgid);
+
+    if (!func || !(ent = slot_msg(raw, msgid))) return (0);
+
+    ent->func = func;
+    ent->arg  = arg;
+    return (1);
+}
+
+/*
+| Function: sub_unicore
+| Purpose:  Subscribe a set of message ids
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw   = Receiver raw data control structure [Input/Output]
+|   Msgid = Message ids to subscribe            [Input]
+|   N     = Number of message ids (0: all ids)  [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->msgtbl
+|
+| Return Value:
+|
+|   1: ok, 0: invalid message id or decoder table full
+|
+| Design Issues:
+|
+|   All ids are subscribed by default. A packet of an id not subscribed is
+|   skipped as a packet without decoder, the message data is CRC32 checked
+|   but not decoded, so that the bytes of a false head are rescanned. With
+|   the -FASTSKIP option it is skipped right after its head, neither stored
+|   nor checked. The subscription is kept when decoders are registered.
+*/
+extern int sub_unicore(raw_t *raw, const int *msgid, int n)
+{
+    msgent_t *ent;
+    int i;
+
+    trace(3, "sub_unicore: n=%d\n", n);
+
+    if (!raw->msgtbl.init) init_msgtbl(raw);
+
+    for (i = 0; i < NMSGTBL; i++) raw->msgtbl.ent[i].sub = 0;
+    raw->msgtbl.suball = n <= 0;
+
+    for (i = 0; i < n; i++)
+    {
+        if (!(ent = slot_msg(raw, msgid[i]))) return (0);
+        ent->sub = 1;
+    }
+    return (1);
+}
+
+/*
+| Function: unreg_unicore
+| Purpose:  Unregister the user decoder of a message id
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw   = Receiver raw data control structure [Input/Output]
+|   Msgid = Message id                          [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->msgtbl
+|
+| Return Value:
+|
+|   1: ok, 0: no user decoder of the id
+|
+| Design Issues:
+|
+|   The built-in decoder of the id, if any, is used again. The table entry
+|   is kept so that the probe sequences of other ids are not broken.
+*/
+extern int unreg_unicore(raw_t *raw, int msgid)
+{
+    msgent_t *ent;
+
+    trace(3, "unreg_unicore: msgid=%d\n", msgid);
+
+    if (!raw->msgtbl.init) init_msgtbl(raw);
+
+    if (!(ent = find_msg(raw, msgid)) || !ent->func) return (0);
+
+    ent->func = NULL;
+    ent->arg  = NULL;
+    return (1);
+}
+
+/*
+| Function: gen_unicore
+| Purpose:  Generate a unicore packet of the decoded data of a message id
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw   = Receiver raw data control structure [Input]
+|   Msgid = Message id                          [Input]
+|   Buff  = Packet frame (header+message+CRC)   [Output]
+|
+| Implicit Inputs:
+|
+|   Raw->cfg.endian
+|   Raw->time
+|   Raw->nav
+|   Raw->ephsat
+|   Raw->gsof
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Packet length (bytes), 0: message id not supported or no data
+|
+| Design Issues:
+|
+|   The message data is encoded by the layout its decoder reads, so that
+|   a generated packet decodes to the same data. Fields not kept by the
+|   decoders are encoded as 0. The ephemeris is the one of Raw->ephsat.
+|   Buff holds at least MAXRAWLEN bytes.
+*/
+extern int gen_unicore(raw_t *raw, int msgid, unsigned char *buff)
+{
+    const int e = raw->cfg.endian;
+    unsigned char *p = buff + HEADLEN;
+    const eph_t *eph;
+    ephmsg_t em;
+    ionmsg_t im = {0};
+    double tow;
+    int len, week, prn, sys = 0;
+
+    trace(3, "gen_unicore: msgid=%d\n", msgid);
+
+    if (raw->ephsat > 0) sys = satsys(raw->ephsat, &prn);
+
+    switch (msgid)
+    {
+    case GPSEPHEM:
+    case BD2EPHEM:
+        if (sys != (msgid == GPSEPHEM ? SYS_GPS : SYS_BDS)) return (0);
+        eph = raw->nav.eph + raw->ephsat - 1;
+        em.eph = *eph;
+        em.prn = sys == SYS_BDS ? prn + 160 : prn;
+        em.tow = (int)timediff(eph->ttr, gpst2time(eph->week, 0.0));
+        em.toe = (unsigned int)eph->toes;
+        em.toc = (int)timediff(eph->toc, gpst2time(eph->week, 0.0));
+        em.ura = eph->sva < 15 ? ura_eph[eph->sva]*ura_eph[eph->sva] :
+                 4.0*ura_eph[14]*ura_eph[14];
+        if (msgid == GPSEPHEM) {put_gpsephem(p, &em, e); len = gpsephem_len;}
+        else                   {put_bd2ephem(p, &em, e); len = bd2ephem_len;}
+        break;
+    case IONUTC:
+        memcpy(im.ion, raw->nav.ion_gps, sizeof(im.ion));
+        memcpy(im.utc, raw->nav.utc_gps, sizeof(im.utc));
+        im.leaps = im.leapsf = raw->nav.leaps;
+        put_ionutc(p, &im, e);
+        len = ionutc_len;
+        break;
+    case BD2IONUTC:
+        memcpy(im.ion, raw->nav.ion_bds, sizeof(im.ion));
+        memcpy(im.utc, raw->nav.utc_bds, sizeof(im.utc));
+        im.leaps = im.leapsf = raw->nav.leaps - 14;
+        put_ionutc(p, &im, e);
+        len = ionutc_len;
+        break;
+    case HEADING: put_heading(p, &raw->gsof.att, e); len = heading_len; break;
+    case PSRPOS:  put_psrpos (p, &raw->gsof.pos, e); len = psrpos_len;  break;
+    case PSRVEL:  put_psrvel (p, &raw->gsof.vel, e); len = psrvel_len;  break;
+    default: return (0);
+    }
+
+    /* Packet head and CRC32 checksum */
+    memset(buff, 0, HEADLEN);
+    buff[0] = SYNC1;
+    buff[1] = SYNC2;
+    buff[2] = SYNC3;
+    buff[3] = HEADLEN;
+    tow = time2gpst(raw->time, &week);
+    U2_PUT(buff+4,  msgid, e);
+    U2_PUT(buff+8,  len, e);
+    U2_PUT(buff+14, week, e);
+    U4_PUT(buff+16, floor(tow*1000.0+0.5), e);
+    U4_PUT(buff+HEADLEN+len, crc32_update(0, buff, HEADLEN+len), e);
+
+    return (HEADLEN+len+4);
+}
+
+/*
+| Function: on_unicore
+| Purpose:  Register the callback of an event type
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw  = Receiver raw data control structure [Input/Output]
+|   Type = Event type (EVT???)                 [Input]
+|   Func = Event callback (NULL: unregister)   [Input]
+|   Arg  = Argument passed to Func             [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->evts
+|
+| Return Value:
+|
+|   1: ok, 0: unknown event type
+|
+| Design Issues:
+|
+|   Func(evt, Arg) is called by decode_unicore_evt() for every message of
+|   the type decoded, evt->data points to the decoded data of the type.
+*/
+extern int on_unicore(raw_t *raw, int type, rawevtcb_t func, void *arg)
+{
+    trace(3, "on_unicore: type=%d\n", type);
+
+    if (type < 0 || type >= NRAWEVT) return (0);
+
+    raw->evts.func[type] = func;
+    raw->evts.arg [type] = func ? arg : NULL;
+    return (1);
+}
+
+/*
+| Function: onbatch_unicore
+| Purpose:  Register the callback of the events of a block
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw  = Receiver raw data control structure [Input/Output]
+|   Func = Batch callback (NULL: unregister)   [Input]
+|   Arg  = Argument passed to Func             [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->evts
+|
+| Return Value:
+|
+|   <none>
+|
+| Design Issues:
+|
+|   Func(evt, n, Arg) is called once by decode_unicore_evt() with the n
+|   events of all the types decoded from the block, in stream order.
+*/
+extern void onbatch_unicore(raw_t *raw, rawbatchcb_t func, void *arg)
+{
+    trace(3, "onbatch_unicore:\n");
+
+    raw->evts.batch = func;
+    raw->evts.barg  = func ? arg : NULL;
+    raw->evts.n = 0;
+    raw->evts.ndata = 0;
+}
+
+/*
+| Function: init_msgtbl
+| Purpose:  Set the built-in decoders in the message decoder table
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw = Receiver raw data control structure [Input/Output]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->msgtbl
+|
+| Return Value:
+|
+|   <none>
+|
+| Design Issues:
+|
+*/
+static void init_msgtbl(raw_t *raw)
+{
+    int i, k;
+
+    for (k = 0; k < NMSGTBL; k++)
+    {
+        raw->msgtbl.ent[k].id = -1;
+        raw->msgtbl.ent[k].le = raw->msgtbl.ent[k].be = NULL;
+        raw->msgtbl.ent[k].func = NULL;
+        raw->msgtbl.ent[k].arg = NULL;
+        raw->msgtbl.ent[k].sub = 0;
+    }
+    for (i = 0; i < (int)(sizeof(msgtbl0)/sizeof(msgtbl0[0])); i++)
+    {
+        for (k = MSGHASH(msgtbl0[i].id); raw->msgtbl.ent[k].id >= 0; )
+            k = (k+1) & (NMSGTBL-1);
+        raw->msgtbl.ent[k] = msgtbl0[i];
+    }
+    raw->msgtbl.suball = 1;
+    raw->msgtbl.init = 1;
+}
+
+/*
+| Function: find_msg
+| Purpose:  Look up the decoder of a message id
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw   = Receiver raw data control structure [Input]
+|   Msgid = Message id                          [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->msgtbl
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Table entry of the decoder, NULL if the id has no decoder or is not
+|   subscribed
+|
+| Design Issues:
+|
+|   Open addressing with linear probing, an id is found in the first probe
+|   unless it collides with another registered id.
+*/
+static INLINE msgent_t *find_msg(raw_t *raw, int msgid)
+{
+    msgent_t *ent;
+    int i, k;
+
+    for (i = 0, k = MSGHASH(msgid); i < NMSGTBL; i++, k = (k+1) & (NMSGTBL-1))
+    {
+        ent = raw->msgtbl.ent + k;
+        if (ent->id == msgid)
+        {
+            if (!ent->func && !ent->le) break;
+            return (raw->msgtbl.suball || ent->sub ? ent : NULL);
+        }
+        if (ent->id < 0) break;
+    }
+    return (NULL);
+}
+
+/*
+| Function: slot_msg
+| Purpose:  Get the table entry of a message id, adding it if not found
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw   = Receiver raw data control structure [Input/Output]
+|   Msgid = Message id                          [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->msgtbl
+|
+| Return Value:
+|
+|   Table entry, NULL if the id is invalid or the table is full
+|
+| Design Issues:
+|
+|   A new entry has no decoder and is not subscribed.
+*/
+static msgent_t *slot_msg(raw_t *raw, int msgid)
+{
+    msgent_t *ent;
+    int i, k;
+
+    if (msgid < 0 || msgid > 0xFFFF) return (NULL);
+
+    if (!raw->msgtbl.init) init_msgtbl(raw);
+
+    for (i = 0, k = MSGHASH(msgid); i < NMSGTBL; i++, k = (k+1) & (NMSGTBL-1))
+    {
+        ent = raw->msgtbl.ent + k;
+        if (ent->id == msgid) return (ent);
+        if (ent->id >= 0) continue;
+
+        ent->id = msgid;
+        ent->le = ent->be = NULL;
+        ent->func = NULL;
+        ent->arg = NULL;
+        ent->sub = 0;
+        return (ent);
+    }
+    trace(2, "unicore: decoder table full, msgid=%d\n", msgid);
+    return (NULL);
+}
+
+/*
+| Function: start_packet
+| Purpose:  Start a new packet after the packet head is synchronized
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw = Receiver raw data control structure [Input]
+|
+| Implicit Inputs:
+|
+|   raw->buff[0-9]
+|
+| Implicit Outputs:
+|
+|   raw->len
+|   raw->nbyte
+|
+| Return Value:
+|
+|   <none>
+|
+| Design Issues:
+|
+|   Packets shorter than the head or longer than the message buffer are
+|   dropped, the stream is synchronized again after the head. The CRC32
+|   of the packet is started with the head bytes. A packet of an id without
+|   decoder or subscription is marked to be skipped, it is only stored and
+|   checked, with the -FASTSKIP option it is neither stored nor checked.
+*/
+static void start_packet(raw_t *raw)
+{
+    raw->len   = packet_len(raw, raw->buff);
+    raw->nbyte = HEADCHK; /* we now have the head in message buffer */
+
+    if (raw->len == 0)
+    {
+        clear_message_buffer(raw);
+        return;
+    }
+    /* Skip the rest of a packet without decoder or subscription */
+    raw->skip = !find_msg(raw, U2(raw->buff+4, raw->cfg.endian));
+    if (raw->skip && !raw->cfg.chkskip) return;
+
+    raw->crc = crc32_update(0, raw->buff, 
+        raw->len-4 < raw->nbyte ? raw->len-4 : raw->nbyte);
+}
+
+/*
+| Function: packet_len
+| Purpose:  Get the length of a packet from its head
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw  = Receiver raw data control structure [Input]
+|   buff = Packet head (HEADCHK bytes)         [Input]
+|
+| Implicit Inputs:
+|
+|   raw->cfg.endian
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Packet length (header + message + CRC32), 0 if it is out of range
+|
+| Design Issues:
+|
+*/
+static int packet_len(raw_t *raw, const unsigned char *buff)
+{
+    int len = buff[3] + U2(buff+8, raw->cfg.endian) + 4;
+
+    if (len <= HEADCHK || len > MAXRAWLEN)
+    {
+        trace(2, "unicore: packet length error, len=%d.\n", len);
+        return (0);
+    }
+    return (len);
+}
+
+/*
+| Function: store_packet
+| Purpose:  Store bytes of the current packet and update its CRC32
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw  = Receiver raw data control structure [Input]
+|   buff = Packet data                         [Input]
+|   n    = Number of bytes (<= raw->len-raw->nbyte) [Input]
+|
+| Implicit Inputs:
+|
+|   raw->len
+|   raw->nbyte
+|   raw->crc
+|
+| Implicit Outputs:
+|
+|   raw->buff[]
+|   raw->nbyte
+|   raw->crc
+|
+| Return Value:
+|
+|   <none>
+|
+| Design Issues:
+|
+|   The CRC32 covers all bytes before the last 4 CRC32 bytes, so a complete
+|   packet is checked by one compare in decode_packet(). The message data
+|   of a skipped packet is only counted, not stored, with the -FASTSKIP
+|   option. Buff may be the bytes to rescan above raw->buff+raw->nbyte.
+*/
+static void store_packet(raw_t *raw, const unsigned char *buff, int n)
+{
+    int m = raw->len-4 - raw->nbyte;    /* bytes left before the CRC32 */
+
+    if (m > n) m = n;
+    if (m < 0) m = 0;
+
+    if (raw->skip && !raw->cfg.chkskip)
+    {
+        raw->nbyte += n;
+        return;
+    }
+    if (m > 0) raw->crc = crc32_update(raw->crc, buff, m);
+
+    memmove(raw->buff+raw->nbyte, buff, n);
+    raw->nbyte += n;
+}
+
+/*
+| Function: decode_packet
+| Purpose:  Check and decode an entire packet
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw  = Receiver raw data control structure [Input]
+|   buff = Packet data, raw->buff or in place  [Input]
+|
+| Implicit Inputs:
+|
+|   raw->len
+|   raw->crc
+|
+| Implicit outputs:
+|
+|   raw->buff[]
+|   raw->len
+|   raw->nbyte
+|   raw->iscan
+|   raw->nscan
+|   raw->time
+|
+| Return Value:
+|
+|   same as decode_unicore()
+|
+| Design Issues:
+|
+|   The bytes of a stored packet failing the CRC32 check, but its first one,
+|   are set to be rescanned by the caller. With the -PAIR or -BUNDLE option
+|   the messages are passed through assemble_msg().
+*/
+static int decode_packet(raw_t *raw, const unsigned char *buff)
+{
+    const msgent_t *ent;
+    int status = 0, len = raw->len;
+    unsigned short msg_id = 0;
+
+    /* The message data of a skipped packet was not stored */
+    if (raw->skip && !raw->cfg.chkskip)
+    {
+        clear_message_buffer(raw);
+        return 0;
+    }
+
+    /* At this point we think we have an entire packet.
+     * Check the packet checksum CRC32 accumulated while storing */
+    if (raw->crc !=
+        U4(buff+raw->len-4, raw->cfg.endian) )
+    {
+        trace(2, "unicore: crc error, len=%d.\n", len);
+        clear_message_buffer(raw);
+
+        /* Rescan the stored bytes after the false head */
+        if (buff == raw->buff)
+        {
+            raw->iscan = 1;
+            raw->nscan = len-1;
+        }
+        return 0;
+    }
+    if (raw->skip)
+    {
+        clear_message_buffer(raw);
+        return 0;
+    }
+
+    /* Get time tag(gpst) from record header */
+    raw->week = U2(buff+14, raw->cfg.endian);
+    raw->seconds = (double)U4(buff+16, raw->cfg.endian)/1000.0;
+    raw->time = gpst2time(raw->week, raw->seconds);
+    raw->tbase= 0;
+
+    /* Get message id */
+    msg_id = U2(buff+4, raw->cfg.endian);
+    raw->msgid = msg_id;
+
+    /* Add to output message type id */
+    if (raw->outtype) {
+        sprintf(raw->msgtype,"unicore %6d (%4d)", msg_id, raw->len);
+    }
+
+    /* Look up the decoder, packets without one are ignored */
+    if (!(ent = find_msg(raw, msg_id)))
+    {
+        clear_message_buffer(raw);
+        return (0);
+    }
+
+#ifdef RANGEH_RANGE
+    /* Convert a raw observation packet of heading antenna */
+    if (msg_id == RANGEH)
+    {
+        extern FILE *rangehb;
+        rangeh2range(raw, buff, rangehb);
+    }
+#endif
+
+    if (ent->func)
+        status = ent->func(raw, buff, ent->arg);
+    else if (raw->cfg.endian == LITTLE_ENDIAN)
+        status = ent->le(raw, buff);
+    else
+        status = ent->be(raw, buff);
+
+    /* Pair and bundle the messages */
+    if (status > 0) status = assemble_msg(raw, status);
+
+    clear_message_buffer(raw);
+    return (status);
+}
+
+
+/*
+| Function: sync_packet
+| Purpose:  Synchronize the raw data stream to the start of a series of unicore packets 
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw  = Receiver raw data control structure [Input]
+|   Data = Next character in raw data stream   [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->buff[0-19]
+|   Raw->nbyte
+|
+| Implicit Outputs:
+|
+|   Raw=>buff[0-19]
+|   Raw->nbyte
+|
+| Return Value:
+|
+|   TRUE  = Start of packet sequence tentatively found
+|   FALSE = Not found, keep reading data bytes from the stream
+|
+| Design Issues:
+|
+|   Bytes are only stored from a sync character on, so raw->buff[0] is always
+|   0xAA while raw->nbyte > 0. A wrong header length rejects the candidate
+|   at once, the packet head is checked once all HEADCHK bytes of the
+|   candidate are in raw->buff.
+*/
+static int sync_packet(raw_t *raw, unsigned char data)
+{
+    if (raw->nbyte == 0 && data != SYNC1) return (0);
+
+    raw->buff[raw->nbyte++] = data;
+
+    /*
+    | Byte 0-2 = synchronize character: 0xAA 0x44 0x12
+    */
+    if ((raw->nbyte == 2 && data != SYNC2) ||
+        (raw->nbyte == 3 && data != SYNC3) ||
+        (raw->nbyte == 4 && data != HEADLEN))
+    {
+        resync_head(raw);
+        return (0);
+    }
+    if (raw->nbyte < HEADCHK) return (0);
+
+    if (check_head(raw, raw->buff)) return (1);
+
+    resync_head(raw);
+    return (0);
+}
+
+/*
+| Function: check_head
+| Purpose:  Check the first 10 bytes of a packet candidate
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw  = Receiver raw data control structure [Input]
+|   Buff = Packet head candidate (HEADCHK bytes) [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   TRUE  = Start of packet sequence tentatively found
+|   FALSE = Not a packet head
+|
+| Design Issues:
+|
+|   The head must be plausible as well as synchronized, so that a false sync
+|   in the message data of a packet seldom makes the stream lose the packets
+|   following it.
+*/
+static int check_head(raw_t *raw, const unsigned char *buff)
+{
+    unsigned short msg_len;     /* message data length */
+
+    /*
+    | Byte 0-2   = synchronize character: 0xAA 0x44 0x12
+    | Byte 3     = header length: 28
+    | Byte 8-9   = message length which must be non-zero for any message we're intrested in,
+    |              and the packet must fit into the message buffer.
+    | Byte 14-15 = gps week
+    | Byte 16-19 = milliseconds of gps week
+    */
+    if (buff[0] != SYNC1 || buff[1] != SYNC2 || buff[2] != SYNC3 ||
+        buff[3] != HEADLEN)
+        return (0);
+
+    /* Parse raw->opt set directly by the caller */
+    if (!raw->cfg.init) setopt_raw(raw, raw->opt);
+    if (!raw->msgtbl.init) init_msgtbl(raw);
+
+    msg_len = U2(buff+8, raw->cfg.endian);
+    if (msg_len == 0 || HEADLEN + msg_len + 4 > MAXRAWLEN)
+        return (0);
+
+    return (U2(buff+14, raw->cfg.endian) <= MAXWEEK &&
+            U4(buff+16, raw->cfg.endian) < WEEKMS);
+}
+
+/*
+| Function: resync_head
+| Purpose:  Drop a rejected packet head candidate and keep its tail from the
+|           next sync character on
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw  = Receiver raw data control structure [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->buff[0-19]
+|   Raw->nbyte
+|
+| Implicit Outputs:
+|
+|   Raw->buff[0-19]
+|   Raw->nbyte
+|
+| Return Value:
+|
+|   <none>
+|
+| Design Issues:
+|
+|   The kept bytes are a prefix of 0xAA 0x44 0x12 followed by any bytes, so
+|   no candidate is lost compared with shifting every byte through the head.
+*/
+static void resync_head(raw_t *raw)
+{
+    int i, n = raw->nbyte;
+
+    for (i=1; i<n; i++)
+    {
+        if (raw->buff[i] != SYNC1) continue;
+        if (i+1 < n && raw->buff[i+1] != SYNC2) continue;
+        if (i+2 < n && raw->buff[i+2] != SYNC3) continue;
+        break;
+    }
+    memmove(raw->buff, raw->buff+i, n-i);
+    raw->nbyte = n-i;
+}
+
+/*
+| Function: scan_sync
+| Purpose:  Search the sync characters in a block of raw data stream
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Buff = Stream data block                   [Input]
+|   N    = Number of bytes in stream data block [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Offset of the first 0xAA 0x44 0x12, or of a prefix of it at the end of
+|   the block (n: not found)
+|
+| Design Issues:
+|
+|   Compares 32 (AVX2) or 16 (SSE2) positions per loop with three unaligned
+|   loads shifted by one byte. The rest of the block and the platforms
+|   without SSE2 use memchr() on the first sync character.
+*/
+static size_t scan_sync(const unsigned char *buff, size_t n)
+{
+    const unsigned char *q;
+    size_t i = 0;
+    unsigned int mask;
+
+#if defined(__AVX2__)
+    const __m256i s1 = _mm256_set1_epi8((char)SYNC1);
+    const __m256i s2 = _mm256_set1_epi8((char)SYNC2);
+    const __m256i s3 = _mm256_set1_epi8((char)SYNC3);
+
+    for (; i+34 <= n; i+=32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(buff+i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(buff+i+1));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(buff+i+2));
+
+        mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, s1), _mm256_cmpeq_epi8(b, s2)),
+            _mm256_cmpeq_epi8(c, s3)));
+        if (mask) return i + ctz32(mask);
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    {
+        const __m128i s1 = _mm_set1_epi8((char)SYNC1);
+        const __m128i s2 = _mm_set1_epi8((char)SYNC2);
+        const __m128i s3 = _mm_set1_epi8((char)SYNC3);
+
+        for (; i+18 <= n; i+=16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(buff+i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(buff+i+1));
+            __m128i c = _mm_loadu_si128((const __m128i *)(buff+i+2));
+
+            mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(a, s1), _mm_cmpeq_epi8(b, s2)),
+                _mm_cmpeq_epi8(c, s3)));
+            if (mask) return i + ctz32(mask);
+        }
+    }
+#endif
+    (void)mask;
+
+    /* Scalar search for the rest */
+    while (i < n && (q = (const unsigned char *)memchr(buff+i, SYNC1, n-i)))
+    {
+        i = (size_t)(q-buff);
+        if ((i+1 >= n || buff[i+1] == SYNC2) && (i+2 >= n || buff[i+2] == SYNC3))
+            return (i);
+        i++;
+    }
+    return (n);
+}
+
+/*
+| Function: read_i2
+| Purpose:  Fetch & convert a signed two byte integer (short)
+| Authors:  Daniel A. Cook
+|
+| Formal Parameters: 
+|
+|   P      = Input pointer        [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Fetched and converted signed two byte integer (short)
+|
+| Design issues:
+|
+|   The data is fetched by memcpy() so as to handle data that is not
+|   naturally aligned. It is then byte swapped if the input endianness
+|   differs from our execution platform endianness. With a constant endian
+|   the test is resolved at compile time.
+*/
+static INLINE short read_i2(const unsigned char *p, int endian) 
+{
+    unsigned short u = read_u2(p, endian);
+    short i2;
+
+    memcpy(&i2, &u, sizeof(i2));
+    return (i2);
+}
+
+/*
+| Function: read_i4
+| Purpose:  Fetch & convert a four byte signed integer (int)
+| Authors:  Daniel A. Cook
+|
+| Formal Parameters: 
+|
+|   P      = Input pointer        [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Fetched and converted four byte signed integer (int)
+|
+| Design issues:
+|
+|   The data is fetched by memcpy() so as to handle data that is not
+|   naturally aligned. It is then byte swapped if the input endianness
+|   differs from our execution platform endianness. With a constant endian
+|   the test is resolved at compile time.
+*/
+static INLINE int read_i4(const unsigned char *p, int endian)
+{
+    unsigned int u = read_u4(p, endian);
+    int i4;
+
+    memcpy(&i4, &u, sizeof(i4));
+    return (i4);
+}
+
+/*
+| Function: read_r4
+| Purpose:  Fetch & convert an IEEE S_FLOAT (float)
+| Authors:  Daniel A. Cook
+|
+| Formal Parameters: 
+|
+|   P      = Input pointer        [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Fetched and converted IEEE S_FLOAT (float)
+|
+| Design issues:
+|
+|   The data is fetched by memcpy() so as to handle data that is not
+|   naturally aligned. It is then byte swapped if the input endianness
+|   differs from our execution platform endianness. With a constant endian
+|   the test is resolved at compile time.
+*/
+static INLINE float read_r4(const unsigned char *p, int endian)
+{
+    unsigned int u = read_u4(p, endian);
+    float f;
+
+    memcpy(&f, &u, sizeof(f));
+    return (f);
+}
+
+/*
+| Function: read_r8
+| Purpose:  Fetch & convert an IEEE T_FLOAT (double)
+| Authors:  Daniel A. Cook
+|
+| Formal Parameters: 
+|
+|   P      = Input pointer        [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Fetched and converted IEEE T_FLOAT (double)
+|
+| Design issues:
+|
+|   The data is fetched by memcpy() so as to handle data that is not
+|   naturally aligned. It is then byte swapped if the input endianness
+|   differs from our execution platform endianness. With a constant endian
+|   the test is resolved at compile time.
+*/
+static INLINE double read_r8(const unsigned char *p, int endian)
+{
+    unsigned long long u;
+    double d;
+
+    memcpy(&u, p, sizeof(u));
+    if (endian != HOST_ENDIAN) u = BSWAP64(u);
+    memcpy(&d, &u, sizeof(d));
+    return (d);
+}
+
+/*
+| Function: read_u2
+| Purpose:  Fetch & convert an unsigned twe byte integer (unsigned short)
+| Authors:  Daniel A. Cook
+|
+| Formal Parameters: 
+|
+|   P      = Input pointer        [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Fetched and converted two byte unsigned integer (unsigned short)
+|
+| Design issues:
+|
+|   The data is fetched by memcpy() so as to handle data that is not
+|   naturally aligned. It is then byte swapped if the input endianness
+|   differs from our execution platform endianness. With a constant endian
+|   the test is resolved at compile time.
+*/
+static INLINE unsigned short read_u2(const unsigned char *p, int endian)
+{
+    unsigned short u;
+
+    memcpy(&u, p, sizeof(u));
+    if (endian != HOST_ENDIAN) u = BSWAP16(u);
+    return (u);
+}
+
+/*
+| Function: read_u4
+| Purpose:  Fetch & convert a four byte unsigned integer (unsigned int)
+| Authors:  Daniel A. Cook
+|
+| Formal Parameters: 
+|
+|   P      = Input pointer        [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Fetched and converted four byte unsigned integer (unsigned int)
+|
+| Design issues:
+|
+|   The data is fetched by memcpy() so as to handle data that is not
+|   naturally aligned. It is then byte swapped if the input endianness
+|   differs from our execution platform endianness. With a constant endian
+|   the test is resolved at compile time.
+*/
+static INLINE unsigned int read_u4(const unsigned char *p, int endian)
+{
+    unsigned int u;
+
+    memcpy(&u, p, sizeof(u));
+    if (endian != HOST_ENDIAN) u = BSWAP32(u);
+    return (u);
+}
+
+/*
+| Function: write_r4
+| Purpose:  Convert & store an IEEE S_FLOAT (float)
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   P      = Output pointer       [Output]
+|   F      = Value to store       [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   <none>
+|
+| Design issues:
+|
+|   The inverse of read_r4(). The data is byte swapped if the output
+|   endianness differs from our execution platform endianness and stored
+|   by memcpy() so as to handle data that is not naturally aligned.
+*/
+static INLINE void write_r4(unsigned char *p, float f, int endian)
+{
+    unsigned int u;
+
+    memcpy(&u, &f, sizeof(u));
+    write_u4(p, u, endian);
+}
+
+/*
+| Function: write_r8
+| Purpose:  Convert & store an IEEE T_FLOAT (double)
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   P      = Output pointer       [Output]
+|   D      = Value to store       [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   <none>
+|
+| Design issues:
+|
+|   The inverse of read_r8(). The data is byte swapped if the output
+|   endianness differs from our execution platform endianness and stored
+|   by memcpy() so as to handle data that is not naturally aligned.
+*/
+static INLINE void write_r8(unsigned char *p, double d, int endian)
+{
+    unsigned long long u;
+
+    memcpy(&u, &d, sizeof(u));
+    if (endian != HOST_ENDIAN) u = BSWAP64(u);
+    memcpy(p, &u, sizeof(u));
+}
+
+/*
+| Function: write_u2
+| Purpose:  Convert & store a two byte unsigned integer (unsigned short)
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   P      = Output pointer       [Output]
+|   U      = Value to store       [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   <none>
+|
+| Design issues:
+|
+|   The inverse of read_u2(). The data is byte swapped if the output
+|   endianness differs from our execution platform endianness and stored
+|   by memcpy() so as to handle data that is not naturally aligned.
+*/
+static INLINE void write_u2(unsigned char *p, unsigned short u, int endian)
+{
+    if (endian != HOST_ENDIAN) u = BSWAP16(u);
+    memcpy(p, &u, sizeof(u));
+}
+
+/*
+| Function: write_u4
+| Purpose:  Convert & store a four byte unsigned integer (unsigned int)
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   P      = Output pointer       [Output]
+|   U      = Value to store       [Input]
+|   Endian = Endianness indicator [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   <none>
+|
+| Design issues:
+|
+|   The inverse of read_u4(). The data is byte swapped if the output
+|   endianness differs from our execution platform endianness and stored
+|   by memcpy() so as to handle data that is not naturally aligned.
+*/
+static INLINE void write_u4(unsigned char *p, unsigned int u, int endian)
+{
+    if (endian != HOST_ENDIAN) u = BSWAP32(u);
+    memcpy(p, &u, sizeof(u));
+}
+
+/*
+| Function: clear_message_buffer
+| Purpose:  Clear the packet buffer
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw = Receiver raw data control structure [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit Outputs:
+|
+|   Raw->len
+|   Raw->nbyte
+|   Raw->skip
+|   Raw->nscan
+|
+| Return Value:
+|
+|   <none>
+|
+| Design issues:
+|
+|   The bytes in raw->buff[] are kept, so those of a packet failing the
+|   CRC32 check can be rescanned after clearing.
+*/
+static void clear_message_buffer(raw_t *raw)
+{
+    raw->len = raw->nbyte = 0;
+    raw->skip = 0;
+    raw->nscan = 0;
+}
+
+/*
+| Function: same_msg
+| Purpose:  Fingerprint a message and check it against the last one
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   Raw = Receiver raw data control structure [Input]
+|   Fp  = Fingerprint of the last message      [Input/Output]
+|   P   = Message data to fingerprint          [Input]
+|   Len = Length of the message data (bytes)   [Input]
+|
+| Implicit Inputs:
+|
+|   Raw->cfg.ephall
+|
+| Implicit Outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   1: same as the last message, 0: changed, first or -EPHALL
+|
+| Design Issues:
+|
+|   The fingerprint is the CRC32 of the data, a few hundred bytes hashed
+|   instead of some thirty fields decoded and converted. A fingerprint of
+|   0 stands for no message, such data are always taken as changed.
+*/
+static INLINE int same_msg(const raw_t *raw, unsigned int *fp,
+                           const unsigned char *p, int len)
+{
+    unsigned int crc = crc32_update(0, p, len);
+
+    if (!raw->cfg.ephall && crc && crc == *fp) return (1);
+    *fp = crc;
+    return (0);
+}
+
+/*
+| Function: decode_bd2ephem
+| Purpose:  Decode a BDS Ephemeris record
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
+|
+| Implicit Inputs:
+|
+|   raw->cfg.ephall
+|
+| Implicit outputs:
+|
+|   raw->nav.beph[]
+|   raw->ephcrc[]
+|   raw->ehist
+|   raw->ephsys
+|   raw->ephprn
+|
+| Return Value:
+|
+|   -1: error message
+|    0: no message (tells caller to please read more data from the stream)
+|    1: input observation data
+|    2: input ephemeris
+|    3: input sbas message
+|    9: input ion/utc parameter
+|   11: input observation data (heading antenna)
+|
+| Design Issues:
+|
+|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
+|   See UnicoreComm command information reference manual V7.7.
+|   The message is fingerprinted from the health on, past the prn and the
+|   time of transmission. An ephemeris of the same fingerprint as the last
+|   of the satellite is not decoded and returns 0, unless -EPHALL.
+*/
+static INLINE int decode_bd2ephem(raw_t *raw, const unsigned char *buff,
+                              int e)
+{
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
+    int sat, prn;
+    ephmsg_t m={0};
+
+    /* Check the message length */
+    if (raw->len-header_len-4 < bd2ephem_len)
+    {
+        trace(2, "unicore: BDS ephemeris length error, len=%d.\n", raw->len);
+        return (-1);
+    }
+
+    /* Check prn */
+    prn = (int)U4(p, e);
+    if (prn < 161 || prn > 197)
+    {
+        trace(0, "unicore: BDS ephemeris satellite number error, PRN=%d.\n", prn);
+        return (-1);
+    }
+
+    /* Skip an unchanged ephemeris before decoding */
+    sat = satno(SYS_BDS, prn - 160);
+    if (same_msg(raw, raw->ephcrc + sat - 1, p + EPHFPOFF, bd2ephem_len - EPHFPOFF))
+        return (0);
+    get_bd2ephem(&m, p, e);
+    m.eph.sva = uraindex(SQRT(m.ura));
+
+    /* Convert  week and tow in gps time to gtime_t struct */
+    m.eph.toes  = m.toe;
+    m.eph.toc   = gpst2time(m.eph.week, m.toc);
+    m.eph.toe   = gpst2time(m.eph.week, m.toe);
+    m.eph.ttr   = gpst2time(m.eph.week, m.tow);
+
+    /* Update BDS nav data */
+    m.eph.sat = sat;
+    raw->nav.eph[sat-1] = m.eph;
+    raw->ephsat = sat;
+    add_ephhist(&raw->ehist, &m.eph);
+
+    return (2);
+}
+
+/*
+| Function: decode_gpsephem
+| Purpose:  Decode a GPS Ephemeris record
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
+|
+| Implicit Inputs:
+|
+|   raw->cfg.ephall
+|
+| Implicit outputs:
+|
+|   raw->nav.geph[]
+|   raw->ephcrc[]
+|   raw->ehist
+|   raw->ephsys
+|   raw->ephprn
+|
+| Return Value:
+|
+|   -1: error message
+|    0: no message (tells caller to please read more data from the stream)
+|    1: input observation data
+|    2: input ephemeris
+|    3: input sbas message
+|    9: input ion/utc parameter
+|   11: input observation data (heading antenna)
+|
+| Design Issues:
+|
+|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
+|   See UnicoreComm command information reference manual V7.7.
+|   The message is fingerprinted from the health on, past the prn and the
+|   time of transmission. An ephemeris of the same fingerprint as the last
+|   of the satellite is not decoded and returns 0, unless -EPHALL.
+*/
+static INLINE int decode_gpsephem(raw_t *raw, const unsigned char *buff,
+                              int e)
+{
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
+    int sat, prn;
+    ephmsg_t m={0};
+
+    /* Check the message length */
+    if (raw->len-header_len-4 < gpsephem_len)
+    {
+        trace(2, "unicore: GPS ephemeris length error, len=%d.\n", raw->len);
+        return (-1);
+    }
+
+    /* Check prn */
+    prn = (int)U4(p, e);
+    if ( prn <= 0 || prn > 32 )
+    {
+        trace(0, "unicore: GPS ephemeris satellite number error, PRN=%d.\n", prn);
+        return (-1);
+    }
+
+    /* Skip an unchanged ephemeris before decoding */
+    sat = satno(SYS_GPS, prn);
+    if (same_msg(raw, raw->ephcrc + sat - 1, p + EPHFPOFF, gpsephem_len - EPHFPOFF))
+        return (0);
+    get_gpsephem(&m, p, e);
+    m.eph.sva = uraindex(SQRT(m.ura));
+
+    /* Convert  week and tow in gps time to gtime_t struct */
+    m.eph.toes  = m.toe;
+    m.eph.toc   = gpst2time(m.eph.week, m.toc);
+    m.eph.toe   = gpst2time(m.eph.week, m.toe);
+    m.eph.ttr   = gpst2time(m.eph.week, m.tow);
+
+    /* Update GPS nav data */
+    m.eph.sat = sat;
+    raw->nav.eph[sat-1] = m.eph;
+    raw->ephsat = sat;
+    add_ephhist(&raw->ehist, &m.eph);
+
+    return (2);
+}
+
+/*
+| Function: decode_bd2ionutc
+| Purpose:  Decode a BDS ion/utc record
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
+|
+| Implicit Inputs:
+|
+|   raw->cfg.ephall
+|
+| Implicit outputs:
+|
+|   raw->nav.ion_bds[]
+|   raw->nav.utc_bds[]
+|   raw->nav.leaps
+|   raw->ioncrc[]
+|
+| Return Value:
+|
+|   -1: error message
+|    0: no message (tells caller to please read more data from the stream)
+|    1: input observation data
+|    2: input ephemeris
+|    3: input sbas message
+|    9: input ion/utc parameter
+|   11: input observation data (heading antenna)
+|
+| Design Issues:
+|
+|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
+|   See UnicoreComm command information reference manual V7.7.
+|   Parameters of the same fingerprint as the last are not decoded and
+|   return 0, unless -EPHALL.
+*/
+static INLINE int decode_bd2ionutc(raw_t *raw, const unsigned char *buff,
+                              int e)
+{
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
+    ionmsg_t m;
+
+    /* Check the message length */
+    if (raw->len-header_len-4 < ionutc_len)
+    {
+        trace(2, "unicore: BDS ion/utc length error, len=%d.\n", raw->len);
+        return (-1);
+    }
+
+    /* Skip unchanged parameters before decoding */
+    if (same_msg(raw, raw->ioncrc + 1, p, ionutc_len)) return (0);
+    get_ionutc(&m, p, e);
+
+    /* update ion and utc parameters in raw->nav */
+    memcpy(raw->nav.ion_bds, m.ion, sizeof(raw->nav.ion_bds));
+    memcpy(raw->nav.utc_bds, m.utc, sizeof(raw->nav.utc_bds));
+
+    /* update leaps */
+    raw->nav.leaps = m.leaps + 14;    /* to convert leaps from bdst to gpst */
+
+    return (9);
+}
+
+/*
+| Function: decode_gpsionutc
+| Purpose:  Decode a GPS ion/utc record
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
+|
+| Implicit Inputs:
+|
+|   raw->cfg.ephall
+|
+| Implicit outputs:
+|
+|   raw->nav.ion_gps[]
+|   raw->nav.utc_gps[]
+|   raw->nav.leaps
+|   raw->ioncrc[]
+|
+| Return Value:
+|
+|   -1: error message
+|    0: no message (tells caller to please read more data from the stream)
+|    1: input observation data
+|    2: input ephemeris
+|    3: input sbas message
+|    9: input ion/utc parameter
+|   11: input observation data (heading antenna)
+|
+| Design Issues:
+|
+|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
+|   See UnicoreComm command information reference manual V7.7.
+|   Parameters of the same fingerprint as the last are not decoded and
+|   return 0, unless -EPHALL.
+*/
+static INLINE int decode_gpsionutc(raw_t *raw, const unsigned char *buff,
+                              int e)
+{
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
+    ionmsg_t m;
+
+    /* Check the message length */
+    if (raw->len-header_len-4 < ionutc_len)
+    {
+        trace(2, "unicore: GPS ion/utc length error, len=%d.\n", raw->len);
+        return (-1);
+    }
+
+    /* Skip unchanged parameters before decoding */
+    if (same_msg(raw, raw->ioncrc + 0, p, ionutc_len)) return (0);
+    get_ionutc(&m, p, e);
+
+    /* update ion and utc parameters in raw->nav */
+    memcpy(raw->nav.ion_gps, m.ion, sizeof(raw->nav.ion_gps));
+    memcpy(raw->nav.utc_gps, m.utc, sizeof(raw->nav.utc_gps));
+
+    /* update leaps */
+    raw->nav.leaps = m.leaps;
+
+    return (9);
+}
+
+/*
+| Function: decode_range
+| Purpose:  Decode a raw observation record
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
+|
+| Implicit Inputs:
+|
+|   raw->time
+|
+| Implicit outputs:
+|
+|   raw->obs
+|   raw->ocol
+|   raw->antno
+|
+| Return Value:
+|
+|   -1: error message
+|    0: no message (tells caller to please read more data from the stream)
+|    1: input observation data
+|    2: input ephemeris
+|    3: input sbas message
+|    9: input ion/utc parameter
+|   11: input observation data (heading antenna)
+|
+| Design Issues:
+|
+|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
+|   See UnicoreComm command information reference manual V7.7.
+|   The records are read into columns by range_cols() and mapped by
+|   range_sigs() before any obs is updated. Records of unmapped signals,
+|   of disabled systems and of satellites beyond MAXOBS are dropped one by
+|   one by range_row(), the rest of the epoch is kept. With the -OBSCOL
+|   option the obs are written to the columns of raw->ocol instead.
+*/
+static INLINE int decode_range(raw_t *raw, const unsigned char *buff,
+                              int e)
+{
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
+    rangecol_t col;                             /* observation records by columns */
+    satrow_t *map = &raw->satrow;               /* satellite to obs row map */
+    obscol_t *ocol = &raw->ocol;                /* obs by columns (-OBSCOL) */
+    obsd_t *obs;
+    int i, k;
+    int nobs;                                   /* observation number*/
+    int nfreq;                                  /* frequency number e.g. L[nfreq] */
+
+    /* Get the number of observations in this epoch */
+    nobs    = I4(p, e); 
+    if (nobs < 0 || nobs > (U2(buff+8, e)-4)/RANGELEN)
+    {
+        trace(2, "unicore: range record number error, nobs=%d.\n", nobs);
+        return (-1);
+    }
+    /* Reset the number of obs in this epoch */
+    raw->obs.n = 0;
+    raw->ocol.n = 0;
+    raw->ocol.time = raw->time;
+    if (++map->gen == 0)
+    {
+        memset(map->sgen, 0, sizeof(map->sgen));
+        map->gen = 1;
+    }
+
+    /* Read the records into columns, then map their signals */
+    range_cols(&col, p+4, nobs, e);
+    range_sigs(&col, nobs);
+
+    /* Update obs one by one */
+    for(i=0; i<nobs; i++)
+    {
+        if ((k = range_row(raw, &col, i)) < 0) continue;
+        nfreq = (col.sig[i] >> 8) & 0xFF;
+
+        if (raw->cfg.obscol)
+        {
+            ocol->P[nfreq][k] = col.psr[i];
+            ocol->L[nfreq][k] = col.adr[i];
+            ocol->D[nfreq][k] = col.dopp[i];
+            ocol->SNR[nfreq][k] = (unsigned char)col.snr[i];
+            ocol->code[nfreq][k]= col.sig[i] & 0xFF;
+            continue;
+        }
+        obs = raw->obs.data + k;
+        obs->P[nfreq] = col.psr[i];
+        obs->L[nfreq] = col.adr[i];
+        obs->D[nfreq] = col.dopp[i];
+        obs->SNR[nfreq] = (unsigned char)col.snr[i]; /* refs to definition */
+        obs->code[nfreq]= col.sig[i] & 0xFF;
+    }
+
+    /* Set antenna number for current obs */
+    raw->antno = 0;
+
+    return (1);
+}
+
+/*
+| Function: range_row
+| Purpose:  Find or add the obs row of the satellite of a RANGE record
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw = Receiver raw data control structure   [Input/Output]
+|   col = Records by columns                    [Input]
+|   i   = Record index                          [Input]
+|
+| Implicit Inputs:
+|
+|   raw->cfg.obscol
+|   raw->time
+|
+| Implicit outputs:
+|
+|   raw->satrow
+|   raw->obs
+|   raw->ocol
+|
+| Return Value:
+|
+|   Obs row, -1: record skipped
+|
+| Design Issues:
+|
+|   The obs row of a satellite is found by raw->satrow, whose rows are
+|   invalidated for a new epoch by one generation increment. A new row is
+|   cleared of the frequencies left over from the last epoch, in raw->obs
+|   or in the columns of raw->ocol by the -OBSCOL option.
+*/
+static INLINE int range_row(raw_t *raw, const rangecol_t *col, int i)
+{
+    satrow_t *map = &raw->satrow;
+    obscol_t *ocol = &raw->ocol;
+    obsd_t *obs;
+    int *n = raw->cfg.obscol ? &ocol->n : &raw->obs.n;
+    int j, k, sys, sat, prn;
+
+    /* Skip the records of unmapped signals */
+    if (!col->sig[i])
+    {
+        trace(3, "unicore: range signal not mapped, stat=%08X.\n", col->stat[i]);
+        return (-1);
+    }
+    sys = (col->sig[i] >> 16) & 0xFF;
+
+    /* Get prn */
+    prn = col->prn[i];
+    if (sys == SYS_GLO && 38<=prn && prn<=62) prn = prn - 37;
+    else if (sys == SYS_BDS && 161<=prn && prn<=197) prn = prn - 160;
+    /* ignore glofreq for glonass */
+
+    if (!(sat = satno(sys, prn)))
+    {
+        trace(3, "unicore: range satellite not supported, sys=%d prn=%d.\n",
+              sys, col->prn[i]);
+        return (-1);
+    }
+
+    /* the satellite already has a record */
+    if (map->sgen[sat] == map->gen) return (map->row[sat]);
+
+    /* not found, then add a new record */
+    if (*n >= MAXOBS)
+    {
+        trace(2, "unicore: range obs overflow, sat=%d.\n", sat);
+        return (-1);
+    }
+    k = (*n)++;
+    map->sgen[sat] = map->gen;
+    map->row[sat] = k;
+
+    /* clear the frequencies left over from the last epoch */
+    if (raw->cfg.obscol)
+    {
+        ocol->sat[k] = (unsigned char)sat;
+        for(j=0; j<NFREQ+NEXOBS; j++) {
+            ocol->P[j][k] = ocol->L[j][k] = 0.0;
+            ocol->D[j][k] = 0.0f;
+            ocol->SNR[j][k] = ocol->LLI[j][k] = 0;
+            ocol->code[j][k] = CODE_NONE;
+        }
+        return (k);
+    }
+    obs = raw->obs.data + k;
+    for(j=0; j<NFREQ+NEXOBS; j++) {
+        obs->P[j] = obs->L[j] = 0.0;
+        obs->D[j] = 0.0f;
+        obs->SNR[j] = obs->LLI[j] = 0;
+        obs->code[j] = CODE_NONE;
+    }
+    obs->sat = sat;
+    obs->time= raw->time;
+    return (k);
+}
+
+/*
+| Function: range_cols
+| Purpose:  Read RANGE observation records into columns
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   col    = Records by columns                 [Output]
+|   p      = First record of the message data   [Input]
+|   n      = Number of records (<= MAXRANGE)    [Input]
+|   endian = Endianness indicator               [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   <none>
+|
+| Design Issues:
+|
+|   On a cpu with AVX2 eight records are read per loop by range_cols_avx2(),
+|   selected at run time. The rest of the records and the cpus without AVX2
+|   read the fields one by one.
+*/
+static INLINE void range_cols(rangecol_t *col, const unsigned char *p, int n,
+                              int e)
+{
+    float cno;
+    int i = 0;
+
+#ifdef RANGE_AVX2
+    if (cpu_avx2()) i = range_cols_avx2(col, p, n, e);
+#endif
+    for (p += i*RANGELEN; i < n; i++, p += RANGELEN)
+    {
+        col->prn [i] = U2(p, e);
+        col->psr [i] = R8(p+4, e);
+        col->adr [i] = -R8(p+16, e);  /* get non-negative value */
+        col->dopp[i] = R4(p+28, e);
+        col->stat[i] = U4(p+40, e);
+
+        /* Signal strength by floor() without a libm call */
+        cno = R4(p+32, e) * 4.0f;
+        col->snr[i] = (int)cno;
+        if (col->snr[i] > cno) col->snr[i]--;
+    }
+}
+
+/*
+| Function: range_sigs
+| Purpose:  Map the tracking status of RANGE records to system, frequency
+|           and code
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   col = Records by columns                    [Input/Output]
+|   n   = Number of records                     [Input]
+|
+| Implicit Inputs:
+|
+|   sigtbl[][]
+|
+| Implicit outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   <none>
+|
+| Design Issues:
+|
+|   The system (bits 16-18) and signal (bits 21-25) fields index sigtbl[][],
+|   on a cpu with AVX2 by one gather for eight records in range_sigs_avx2().
+|   Signals not in the table are mapped to 0 and left to the caller to skip
+|   record by record.
+*/
+static INLINE void range_sigs(rangecol_t *col, int n)
+{
+    int i = 0;
+
+#ifdef RANGE_AVX2
+    if (cpu_avx2()) i = range_sigs_avx2(col, n);
+#endif
+    for (; i < n; i++)
+    {
+        col->sig[i] = sigtbl[(col->stat[i] >> 16) & 0x07][(col->stat[i] >> 21) & 0x1F];
+    }
+}
+
+#ifdef RANGE_AVX2
+/*
+| Function: range_cols_avx2
+| Purpose:  Read RANGE observation records into columns by AVX2
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   col    = Records by columns                 [Output]
+|   p      = First record of the message data   [Input]
+|   n      = Number of records (<= MAXRANGE)    [Input]
+|   endian = Endianness indicator               [Input]
+|
+| Implicit Inputs:
+|
+|   <none>
+|
+| Implicit outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Number of records read, a multiple of 8
+|
+| Design Issues:
+|
+|   Eight records are read per loop, every field by one gather at stride
+|   RANGELEN and one byte shuffle if the stream endian differs from the
+|   platform. Only called if cpu_avx2() is true, the rest of the records
+|   is left to range_cols().
+*/
+AVX2_TARGET
+static int range_cols_avx2(rangecol_t *col, const unsigned char *p, int n,
+                           int e)
+{
+    const __m256i off = _mm256_setr_epi32(0, RANGELEN, 2*RANGELEN, 3*RANGELEN,
+                        4*RANGELEN, 5*RANGELEN, 6*RANGELEN, 7*RANGELEN);
+    const __m128i off2 = _mm_setr_epi32(0, RANGELEN, 2*RANGELEN, 3*RANGELEN);
+    const __m256i swap4 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9,
+                        8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9,
+                        8, 15, 14, 13, 12);
+    const __m256i swap8 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13,
+                        12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13,
+                        12, 11, 10, 9, 8);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256 four = _mm256_set1_ps(4.0f);
+    const unsigned char *q;
+    __m256i v;
+    int i = 0, j;
+
+    for (; i+8 <= n; i+=8)
+    {
+        q = p + i*RANGELEN;
+
+        v = _mm256_i32gather_epi32((const int *)q, off, 1);
+        if (e != HOST_ENDIAN) v = _mm256_srli_epi32(_mm256_shuffle_epi8(v, swap4), 16);
+        else v = _mm256_and_si256(v, _mm256_set1_epi32(0xFFFF));
+        _mm256_storeu_si256((__m256i *)(col->prn+i), v);
+
+        v = _mm256_i32gather_epi32((const int *)(q+28), off, 1);
+        if (e != HOST_ENDIAN) v = _mm256_shuffle_epi8(v, swap4);
+        _mm256_storeu_si256((__m256i *)(col->dopp+i), v);
+
+        v = _mm256_i32gather_epi32((const int *)(q+32), off, 1);
+        if (e != HOST_ENDIAN) v = _mm256_shuffle_epi8(v, swap4);
+        v = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(
+            _mm256_castsi256_ps(v), four)));
+        _mm256_storeu_si256((__m256i *)(col->snr+i), v);
+
+        v = _mm256_i32gather_epi32((const int *)(q+40), off, 1);
+        if (e != HOST_ENDIAN) v = _mm256_shuffle_epi8(v, swap4);
+        _mm256_storeu_si256((__m256i *)(col->stat+i), v);
+
+        for (j = 0; j < 8; j+=4)
+        {
+            v = _mm256_i32gather_epi64((const long long *)(q+j*RANGELEN+4),
+                                       off2, 1);
+            if (e != HOST_ENDIAN) v = _mm256_shuffle_epi8(v, swap8);
+            _mm256_storeu_pd(col->psr+i+j, _mm256_castsi256_pd(v));
+
+            v = _mm256_i32gather_epi64((const long long *)(q+j*RANGELEN+16),
+                                       off2, 1);
+            if (e != HOST_ENDIAN) v = _mm256_shuffle_epi8(v, swap8);
+            _mm256_storeu_pd(col->adr+i+j,
+                             _mm256_xor_pd(_mm256_castsi256_pd(v), sign));
+        }
+    }
+    return (i);
+}
+
+/*
+| Function: range_sigs_avx2
+| Purpose:  Map the tracking status of RANGE records by AVX2
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   col = Records by columns                    [Input/Output]
+|   n   = Number of records                     [Input]
+|
+| Implicit Inputs:
+|
+|   sigtbl[][]
+|
+| Implicit outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   Number of records mapped, a multiple of 8
+|
+| Design Issues:
+|
+|   Eight records are mapped by one gather of sigtbl[][]. Only called if
+|   cpu_avx2() is true, the rest of the records is left to range_sigs().
+*/
+AVX2_TARGET
+static int range_sigs_avx2(rangecol_t *col, int n)
+{
+    const __m256i m3 = _mm256_set1_epi32(0x07), m5 = _mm256_set1_epi32(0x1F);
+    __m256i v, idx;
+    int i = 0;
+
+    for (; i+8 <= n; i+=8)
+    {
+        v = _mm256_loadu_si256((const __m256i *)(col->stat+i));
+        idx = _mm256_or_si256(
+            _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(v, 16), m3), 5),
+            _mm256_and_si256(_mm256_srli_epi32(v, 21), m5));
+        v = _mm256_i32gather_epi32((const int *)sigtbl[0], idx, 4);
+        _mm256_storeu_si256((__m256i *)(col->sig+i), v);
+    }
+    return (i);
+}
+#endif /* RANGE_AVX2 */
+
+/*
+| Function: decode_rangeh
+| Purpose:  Decode a raw observation record of the heading antenna
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
+|
+| Implicit Inputs:
+|
+|   raw->time
+|
+| Implicit outputs:
+|
+|   raw->obs
+|   raw->antno
+|
+| Return Value:
+|
+|   -1: error message
+|    0: no message (tells caller to please read more data from the stream)
+|    1: input observation data
+|    2: input ephemeris
+|    3: input sbas message
+|    9: input ion/utc parameter
+|   11: input observation data (heading antenna)
+|
+| Design Issues:
+|
+|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
+|   See UnicoreComm command information reference manual V7.7.
+*/
+static INLINE int decode_rangeh(raw_t *raw, const unsigned char *buff,
+                              int e)
+{
+    int status;
+
+    if(status=decode_range(raw, buff, e) == 1) {
+        raw->antno = 1; /* set the antenna number for current obs */
+        return (11);
+    }
+    
+    return (status);
+}
+
+/*
+| Function: assemble_msg
+| Purpose:  Pass a decoded message to the epoch pairing and bundling
+| Authors:  Guangli Dong
+|
+| Formal Parameters: 
+|
+|   raw    = Receiver raw data control structure [Input/Output]
+|   status = Status of the decoded message (> 0) [Input]
+|
+| Implicit Inputs:
+|
+|   raw->cfg.pairtt
+|   raw->cfg.bundle
+|
+| Implicit outputs:
+|
+|   <none>
+|
+| Return Value:
+|
+|   same as decode_unicore()
+|
+| Design Issues:
+|
+|   Without the -PAIR and -BUNDLE options the status is returned as is.
+*/
+static int assemble_msg(raw_t *raw, int status)
 {
-    int i;
-
-    memset(raw->buff, 0x00, 10);
+    if ((status == 1 || status == 11) && raw->cfg.pairtt > 0.0)
+        status = pair_obs(raw, status);
+    if (status > 0 && raw->cfg.bundle)
+        status = bundle_msg(raw, status);
 
-    raw->len = raw->nbyte = 0;
+    return (status);
 }
 
 /*
-| Function: decode_bd2ephem
-| Purpose:  Decode a BDS Ephemeris record
+| Function: pair_obs
+| Purpose:  Pair the epochs of observation data of the master and heading antenna
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   Raw = Receiver raw data control structure [Input]
-|   Endian = Endianness indicator             [Input]
+|   raw    = Receiver raw data control structure [Input/Output]
+|   status = Status of the decoded epoch (1, 11) [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   raw->time
+|   raw->cfg.pairtt
+|   raw->cfg.obscol
+|   raw->cfg.sdiff
+|   raw->ocol
 |
 | Implicit outputs:
 |
-|   raw->nav.beph[]
-|   raw->ephsys
-|   raw->ephprn
+|   raw->obs
+|   raw->obuf
+|   raw->tobs
+|   raw->pair
+|   raw->sd
 |
 | Return Value:
 |
-|   -1: error message
-|    0: no message (tells caller to please read more data from the stream)
-|    1: input observation data
-|    2: input ephemeris
-|    3: input sbas message
-|    9: input ion/utc parameter
-|   11: input observation data (heading antenna)
+|    0: epoch held until the epoch of the other antenna
+|   12: input observation data pair (raw->obs: master, raw->obuf: heading
+|       antenna)
 |
 | Design Issues:
 |
-|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
-|   See UnicoreComm command information reference manual V7.7.
+|   Up to MAXPAIRBUF epochs of each antenna are held in time order. An epoch
+|   is paired with the held epoch of the other antenna within DTTOL, the held
+|   ones before it can never be paired then and are dropped. Epochs held for
+|   more than raw->cfg.pairtt seconds of message time are dropped too, so are
+|   the oldest epochs of an antenna beyond MAXPAIRBUF. The records are never
+|   copied, the MAXOBS buffers of raw->obs, raw->obuf and the held epochs are
+|   exchanged instead. With the -OBSCOL option the columns are converted to
+|   records first, the pair is output in raw->obs and raw->obuf. With the
+|   -SDIFF option the single differences of the pair are formed in raw->sd
+|   by sdiff_obs() at once.
 */
-static int decode_bd2ephem(raw_t *raw, int e)
+static int pair_obs(raw_t *raw, int status)
 {
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    int satnum, prn, sat, toc, tow, sys;
-    unsigned int flags, toe;
-    double sqrtA, ura;
-    eph_t eph={0};
-    struct tm *tm_tm;
+    obspair_t *pair = &raw->pair;
+    pairep_t *ep;
+    obsd_t *data;
+    int a = status == 11 ? 1 : 0, b = 1 - a, i, k;
 
-    /* Get prn */
-    satnum = U4(p, e);                     /* 000-003: System PRN */
-    if (satnum < 161 || satnum > 197)
+    if (raw->cfg.obscol) obscol2obs(&raw->ocol, &raw->obs);
+
+    /* Drop the held epochs timed out */
+    for (k = 0; k < 2; k++)
     {
-        trace(0, "unicore: BDS ephemeris satellite number error, PRN=%d.\n", prn);
-        return (-1);
+        for (i = 0; i < pair->n[k]; i++)
+        {
+            if (timediff(raw->time, pair->ep[k][i].time) <= raw->cfg.pairtt) break;
+        }
+        if (i > 0) drop_pair(pair, k, i, i);
     }
-    prn = satnum - 160;
-
-    tow     = (int)R8(p+4, e);          /* 004-011: Time (s) of 1st subfram in week, based on GPS time */
-    eph.svh = U4(p+12, e);              /* 012-015: SV health */
-    eph.aode= U4(p+16, e);              /* 016-019: AODE Age Of Data, Ephemeris*/
-                                        /* 020-023: Another AODE, ignored */
-    eph.week= U4(p+24, e);              /* 024-027: GPS Week */
-                                        /* 028-031: Z week based on GPS for week-roll, ignored */
-    toe     = (unsigned int)R8(p+32, e);/* 032-039: Ephemeris reference time */
-    eph.A   = R8(p+40, e);              /* 040-047: Semi-major axis (m) */
-    eph.deln= R8(p+48, e);              /* 048-055: Correction of mean angle velocity (rad/s) */
-    eph.M0  = R8(p+56, e);              /* 056-063: Mean anomaly at reference time (rad) */
-    eph.e   = R8(p+64, e);              /* 064-071: Eccentricity */
-    eph.omg = R8(p+72, e);              /* 072-079: Argument of perigee (rad) */
-    eph.cuc = R8(p+80, e);              /* 080-087: Amplitude of consine harmonic correction term to argument of latitude (rad) */
-    eph.cus = R8(p+88, e);              /* 088-095: Amplitude of sine harmonic correction term to argument of latitude (rad) */
-    eph.crc = R8(p+96, e);              /* 096-103: Amplitude of consine harmonic correction term to orbit radius (m) */
-    eph.crs = R8(p+104, e);             /* 103-111: Amplitude of sine harmonic correction term to orbit radius (m) */
-    eph.cic = R8(p+112, e);             /* 112-119: Amplitude of consine harmonic correction term to angle of inclination (rad) */
-    eph.cis = R8(p+120, e);             /* 120-127: Amplitude of sine harmonic correction term to angle of inclination (rad) */
-    eph.i0  = R8(p+128, e);             /* 128-135: Inclination angle at reference time (rad) */
-    eph.idot= R8(p+136, e);             /* 136-143: Rate of inclination anlge (rad/s) */
-    eph.OMG0= R8(p+144, e);             /* 134-151: Longitude of ascending node (rad) */
-    eph.OMGd= R8(p+152, e);             /* 152-159: Rate of Longitude of ascending node (rad/s) */
-    eph.aodc= U4(p+160, e);             /* 160-163: Age of data, clock */
-    toc     = (int)R8(p+164, e);        /* 164-171: Reference time of clock parameters (s) */
-    eph.tgd[0]  = R8(p+172, e);         /* 172-179: Equipment group delay differential of B1 (s) */
-    eph.tgd[1]  = R8(p+180, e);         /* 180-187: Equipment group delay differential of B2 (s) */
-    eph.f0  = R8(p+188, e);             /* 188-195: Satellite clock bias (s) */
-    eph.f1  = R8(p+196, e);             /* 196-203: Satellite clock rate (s/s) */
-    eph.f2  = R8(p+204, e);             /* 204-211: Satellite clock acceleration (s/s^2) */
-                                        /* 212-215: Anti-sproof, ignored */
-//    eph.n   = R8(p+216, e);             /* 216-223: Corrected mean angle rate (rad/s) */
-    ura     = R8(p+224, e);             /* 224-231: SV accuracy (m^2) */
-    eph.sva = uraindex(SQRT(ura));
 
-    /* Convert  week and tow in gps time to gtime_t struct */
-    eph.toes  = toe;
-    eph.toc   = gpst2time(eph.week, toc);
-    eph.toe   = gpst2time(eph.week, toe);
-    eph.ttr   = gpst2time(eph.week, tow);
+    /* Find the held epoch of the other antenna at the time */
+    for (i = 0; i < pair->n[b]; i++)
+    {
+        if (fabs(timediff(raw->time, pair->ep[b][i].time)) < DTTOL) break;
+    }
+    if (i >= pair->n[b])
+    {
+        /* Hold the epoch, the oldest one is dropped if no room */
+        if (pair->n[a] >= MAXPAIRBUF) drop_pair(pair, a, 1, 1);
+        ep = pair->ep[a] + pair->n[a]++;
+        data = ep->data; ep->data = raw->obs.data; raw->obs.data = data;
+        ep->n = raw->obs.n;
+        ep->time = raw->time;
+        raw->obs.n = 0;
+        return (0);
+    }
+    ep = pair->ep[b] + i;
 
-    /* Update BDS nav data */
-    sat = satno(SYS_BDS, prn);
-    eph.sat = sat;
-    raw->nav.eph[sat-1] = eph;
-    raw->ephsat = sat;
+    /* Output the heading antenna in raw->obuf, the master one in raw->obs */
+    if (a == 0)
+    {
+        data = raw->obuf.data; raw->obuf.data = ep->data; ep->data = data;
+        raw->obuf.n = ep->n;
+    }
+    else
+    {
+        data = raw->obuf.data; raw->obuf.data = raw->obs.data;
+        raw->obs.data = ep->data; ep->data = data;
+        raw->obuf.n = raw->obs.n;
+        raw->obs.n = ep->n;
+    }
+    raw->tobs = raw->time;
+    drop_pair(pair, b, i+1, i);
 
-    return (2);
+    if (raw->cfg.sdiff) sdiff_obs(&raw->obs, &raw->obuf, &raw->sd);
+
+    return (12);
 }
 
 /*
-| Function: decode_gpsephem
-| Purpose:  Decode a GPS Ephemeris record
+| Function: drop_pair
+| Purpose:  Drop the oldest epochs held for antenna pairing
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   rndian = Endianness indicator             [Input]
+|   pair  = Dual-antenna epoch pairing          [Input/Output]
+|   a     = Antenna (0: master, 1: heading)     [Input]
+|   n     = Number of epochs to drop            [Input]
+|   ndrop = Number of them counted unpaired     [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   <none>
 |
 | Implicit outputs:
 |
-|   raw->nav.geph[]
-|   raw->ephsys
-|   raw->ephprn
+|   <none>
 |
 | Return Value:
 |
-|   -1: error message
-|    0: no message (tells caller to please read more data from the stream)
-|    1: input observation data
-|    2: input ephemeris
-|    3: input sbas message
-|    9: input ion/utc parameter
-|   11: input observation data (heading antenna)
+|   <none>
 |
 | Design Issues:
 |
-|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
-|   See UnicoreComm command information reference manual V7.7.
+|   The buffers of the dropped epochs are moved behind the held ones to be
+|   used again.
 */
-static int decode_gpsephem(raw_t *raw, int e)
+static void drop_pair(obspair_t *pair, int a, int n, int ndrop)
 {
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    int satnum, prn, sat, toc, tow, sys;
-    unsigned int flags, toe;
-    double sqrtA, ura;
-    eph_t eph={0};
-    struct tm *tm_tm;
-
-    /* Get prn */
-    satnum = U4(p, e);                     /* 000-003: System PRN */
-    if ( satnum <= 0 || satnum > 32 )
-    {
-        trace(0, "unicore: GPS ephemeris satellite number error, PRN=%d.\n", prn);
-        return (-1);
-    }
-    prn = satnum;
-
-    tow     = (int)R8(p+4, e);          /* 004-011: Time (s) of 1st subfram in week, based on GPS time */
-    eph.svh = U4(p+12, e);              /* 012-015: SV health */
-                                        /* 016-019: ephemeris #1 age */
-    eph.iode= U4(p+20, e);              /* 020-023: ephemeris #2 age = GPS IODE1 */
-    eph.week= U4(p+24, e);              /* 024-027: GPS Week */
-                                        /* 028-031: Z week based on GPS for week-roll, ignored */
-    toe     = (unsigned int)R8(p+32, e);/* 032-039: Ephemeris reference time */
-    eph.A   = R8(p+40, e);              /* 040-047: Semi-major axis (m) */
-    eph.deln= R8(p+48, e);              /* 048-055: Correction of mean angle velocity (rad/s) */
-    eph.M0  = R8(p+56, e);              /* 056-063: Mean anomaly at reference time (rad) */
-    eph.e   = R8(p+64, e);              /* 064-071: Eccentricity */
-    eph.omg = R8(p+72, e);              /* 072-079: Argument of perigee (rad) */
-    eph.cuc = R8(p+80, e);              /* 080-087: Amplitude of consine harmonic correction term to argument of latitude (rad) */
-    eph.cus = R8(p+88, e);              /* 088-095: Amplitude of sine harmonic correction term to argument of latitude (rad) */
-    eph.crc = R8(p+96, e);              /* 096-103: Amplitude of consine harmonic correction term to orbit radius (m) */
-    eph.crs = R8(p+104, e);             /* 103-111: Amplitude of sine harmonic correction term to orbit radius (m) */
-    eph.cic = R8(p+112, e);             /* 112-119: Amplitude of consine harmonic correction term to angle of inclination (rad) */
-    eph.cis = R8(p+120, e);             /* 120-127: Amplitude of sine harmonic correction term to angle of inclination (rad) */
-    eph.i0  = R8(p+128, e);             /* 128-135: Inclination angle at reference time (rad) */
-    eph.idot= R8(p+136, e);             /* 136-143: Rate of inclination anlge (rad/s) */
-    eph.OMG0= R8(p+144, e);             /* 134-151: Longitude of ascending node (rad) */
-    eph.OMGd= R8(p+152, e);             /* 152-159: Rate of Longitude of ascending node (rad/s) */
-    eph.aodc= U4(p+160, e);             /* 160-163: Age of data, clock */
-    toc     = (int)R8(p+164, e);        /* 164-171: Reference time of clock parameters (s) */
-    eph.tgd[0]  = R8(p+172, e);         /* 172-179: Equipment group delay differential (s) */
-    eph.f0  = R8(p+180, e);             /* 180-187: Satellite clock bias (s) */
-    eph.f1  = R8(p+188, e);             /* 188-195: Satellite clock rate (s/s) */
-    eph.f2  = R8(p+196, e);             /* 196-203: Satellite clock acceleration (s/s^2) */
-                                        /* 204-207: Anti-sproof, ignored */
-//    eph.n   = R8(p+208, e);             /* 208-215: Corrected mean angle rate (rad/s) */
-    ura     = R8(p+216, e);                 /* 216-223: SV accuracy (m^2) */
-    eph.sva = uraindex(SQRT(ura));
-
-    /* Convert  week and tow in gps time to gtime_t struct */
-    eph.toes  = toe;
-    eph.toc   = gpst2time(eph.week, toc);
-    eph.toe   = gpst2time(eph.week, toe);
-    eph.ttr   = gpst2time(eph.week, tow);
+    pairep_t tmp[MAXPAIRBUF];
 
-    /* Update GPS nav data */
-    sat = satno(SYS_GPS, prn);
-    eph.sat = sat;
-    raw->nav.eph[sat-1] = eph;
-    raw->ephsat = sat;
+    if (ndrop > 0) trace(2, "unicore: epoch dropped unpaired, ant=%d n=%d.\n", a, ndrop);
+    pair->ndrop += ndrop;
 
-    return (2);
+    memcpy(tmp, pair->ep[a], sizeof(pairep_t)*n);
+    memmove(pair->ep[a], pair->ep[a]+n, sizeof(pairep_t)*(MAXPAIRBUF-n));
+    memcpy(pair->ep[a]+MAXPAIRBUF-n, tmp, sizeof(pairep_t)*n);
+    pair->n[a] -= n;
 }
 
 /*
-| Function: decode_bd2ionutc
-| Purpose:  Decode a BDS ion/utc record
+| Function: bundle_msg
+| Purpose:  Bundle the observation and gsof messages of an epoch
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   raw    = Receiver raw data control structure [Input/Output]
+|   status = Status of the decoded message (> 0) [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   raw->week
+|   raw->seconds
+|   raw->time
+|   raw->cfg.obscol
+|   raw->ocol
 |
 | Implicit outputs:
 |
-|   raw->nav.ion_bds[]
-|   raw->nav.utc_bds[]
-|   raw->nav.leaps
+|   raw->obs
+|   raw->obuf
+|   raw->gsof
+|   raw->tobs
+|   raw->bnd
 |
 | Return Value:
 |
-|   -1: error message
-|    0: no message (tells caller to please read more data from the stream)
-|    1: input observation data
-|    2: input ephemeris
-|    3: input sbas message
-|    9: input ion/utc parameter
-|   11: input observation data (heading antenna)
+|    0: message held in the bundle
+|   31: input epoch bundle
+|   other statuses of messages not bundled are returned as is
 |
 | Design Issues:
 |
-|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
-|   See UnicoreComm command information reference manual V7.7.
+|   The messages of status 1, 11, 12 and 21-24 are grouped by header week
+|   and ms. The interval of each kind of message is learned by
+|   learn_bundle(), so the set of messages expected at an epoch is known
+|   and the bundle is output the moment the set is complete. A bundle still
+|   incomplete is output when a message of another epoch comes, the message
+|   then starts the other bundle. If that message alone completes it, it is
+|   set pending and output by the next call of decode_unicore_buf() before
+|   any byte is consumed. Messages not expected at an epoch (while the
+|   intervals are learned) come in another bundle of the same epoch. The
+|   two bundles are filled by turns and the
+|   observation buffers are exchanged with raw->obs and raw->obuf, not
+|   copied. The output bundle is in raw->obs, raw->obuf, raw->gsof and
+|   raw->tobs, raw->bnd.mask tells which of them are in the bundle and
+|   raw->bnd.set which were expected.
 */
-static int decode_bd2ionutc(raw_t *raw, int e)
-{
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    double a0, a1, a2, a3, b0, b1, b2, b3;      /* ion parameters */
-    double A0, A1;                              /* utc parameter */
-    unsigned long utc_wn, tot;                  /* reference time of utc paramters */ 
-    unsigned long wn_lsf, dn;                   /* new leap second effect week and day of week
-                                                   dn: 0-6, 0 for Sunday */
-    long deltat_ls, deltat_lsf;                 /* bds leap seconds before / after new leap second
-                                                   effective */
-    unsigned long deltat_utc;                   /* difference between BDT and UTC */
-
-    /* Decode ion parameters */
-    a0  = R8(p,    e);
-    a1  = R8(p+8,  e);
-    a2  = R8(p+16, e);
-    a3  = R8(p+24, e);    
-    b0  = R8(p+32, e);
-    b1  = R8(p+40, e);
-    b2  = R8(p+48, e);
-    b3  = R8(p+56, e);
-
-    /* Decode utc parameters */
-    utc_wn  = U4(p+64, e);
-    tot     = U4(p+68, e);
-    A0      = R8(p+72, e);
-    A1      = R8(p+80, e);
-
-    /* Decode other parameters */
-    wn_lsf  = U4(p+88, e);
-    dn      = U4(p+92, e);
-    deltat_ls   = I4(p+96, e);
-    deltat_lsf  = I4(p+100, e);
-    deltat_utc  = U4(p+104, e);
+static int bundle_msg(raw_t *raw, int status)
+{
+    bundle_t *bnd = &raw->bnd;
+    bndep_t *ep;
+    obsd_t *data;
+    unsigned int bits, set;
+    int i, k, ms, n, next = 0;
 
-    /* update ion and utc parameters in raw->nav */
-    raw->nav.ion_bds[0] = a0;
-    raw->nav.ion_bds[1] = a1;
-    raw->nav.ion_bds[2] = a2;
-    raw->nav.ion_bds[3] = a3;
-    raw->nav.ion_bds[4] = b0;
-    raw->nav.ion_bds[5] = b1;
-    raw->nav.ion_bds[6] = b2;
-    raw->nav.ion_bds[7] = b3;
-
-    raw->nav.utc_bds[0] = A0;
-    raw->nav.utc_bds[1] = A1;
-    raw->nav.utc_bds[2] = tot;
-    raw->nav.utc_bds[3] = utc_wn;
+    switch (status)
+    {
+        case 1:  bits = BNDRANGE;  break;
+        case 11: bits = BNDRANGEH; break;
+        case 12: bits = BNDRANGE | BNDRANGEH; break;
+        case 21: bits = BNDPOS;    break;
+        case 22: bits = BNDVEL;    break;
+        case 23: bits = BNDATT;    break;
+        case 24: bits = BNDSAT;    break;
+        default: return (status);
+    }
+    if (raw->cfg.obscol && (status == 1 || status == 11))
+        obscol2obs(&raw->ocol, &raw->obs);
 
-    /* update leaps */
-    raw->nav.leaps = deltat_ls + 14;    /* to convert leaps from bdst to gpst */
+    ms = (int)(raw->seconds * 1000.0 + 0.5);
+    learn_bundle(bnd, bits, raw->week, ms);
 
-    return (9);
+    /* A message of another epoch outputs the bundle incomplete */
+    ep = bnd->ep + bnd->acc;
+    if (ep->mask && (ep->week != raw->week || ep->ms != ms))
+    {
+        bnd->acc ^= 1;
+        ep = bnd->ep + bnd->acc;
+        ep->mask = 0;
+        next = 1;
+    }
+    ep->time = raw->time;
+    ep->week = raw->week;
+    ep->ms   = ms;
+
+    /* Move the message into the bundle */
+    for (i = 0; i < 2; i++)
+    {
+        if (!(bits & (i ? BNDRANGEH : BNDRANGE))) continue;
+        k = status == 12 && i ? 1 : 0;      /* RANGEH in raw->obuf of a pair */
+        if (k)
+        {
+            data = raw->obuf.data; raw->obuf.data = ep->obs[i].data;
+            n = raw->obuf.n; raw->obuf.n = 0;
+        }
+        else
+        {
+            data = raw->obs.data; raw->obs.data = ep->obs[i].data;
+            n = raw->obs.n; raw->obs.n = 0;
+        }
+        ep->obs[i].data = data;
+        ep->obs[i].n = n;
+    }
+    if (bits & BNDPOS) ep->gsof.pos = raw->gsof.pos;
+    if (bits & BNDVEL) ep->gsof.vel = raw->gsof.vel;
+    if (bits & BNDATT) ep->gsof.att = raw->gsof.att;
+    if (bits & BNDSAT)
+    {
+        ep->gsof.sat.num = raw->gsof.sat.num < MAXOBS ?
+                             raw->gsof.sat.num : MAXOBS;
+        memcpy(ep->gsof.sat.data, raw->gsof.sat.data,
+               sizeof(gsof_satd_t) * ep->gsof.sat.num);
+    }
+    ep->mask |= bits;
+
+    set = bundle_set(bnd, ms);
+    if (next)
+    {
+        out_bundle(raw, bnd->ep + (bnd->acc ^ 1));
+        bnd->pend = set && (ep->mask & set) == set;
+        return (31);
+    }
+    if (!set || (ep->mask & set) != set) return (0);
+
+    out_bundle(raw, ep);
+    return (31);
 }
 
 /*
-| Function: decode_gpsionutc
-| Purpose:  Decode a GPS ion/utc record
+| Function: learn_bundle
+| Purpose:  Learn the intervals of the messages of an epoch bundle
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   bnd  = Epoch bundler                        [Input/Output]
+|   bits = Kinds of the message (BND???)        [Input]
+|   week = Header week of the message           [Input]
+|   ms   = Header ms of the message             [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   <none>
 |
 | Implicit outputs:
 |
-|   raw->nav.ion_gps[]
-|   raw->nav.utc_gps[]
-|   raw->nav.leaps
+|   <none>
 |
 | Return Value:
 |
-|   -1: error message
-|    0: no message (tells caller to please read more data from the stream)
-|    1: input observation data
-|    2: input ephemeris
-|    3: input sbas message
-|    9: input ion/utc parameter
-|   11: input observation data (heading antenna)
+|   <none>
 |
 | Design Issues:
 |
-|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
-|   See UnicoreComm command information reference manual V7.7.
+|   An interval is taken once it is seen twice in a row, so a message lost
+|   does not change the learned interval. An interval is forgotten when the
+|   message is not seen for three intervals (e.g. the log of it stopped),
+|   so the bundles are not held waiting for it.
 */
-static int decode_gpsionutc(raw_t *raw, int e)
-{
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    double a0, a1, a2, a3, b0, b1, b2, b3;      /* ion parameters */
-    double A0, A1;                              /* utc parameter */
-    unsigned long utc_wn, tot;                  /* reference time of utc paramters */ 
-    unsigned long wn_lsf, dn;                   /* new leap second effect week and day of week
-                                                   dn: 0-6, 0 for Sunday */
-    long deltat_ls, deltat_lsf;                 /* gps leap seconds before / after new leap second
-                                                   effective */
-    unsigned long deltat_utc;                   /* difference between GPST and UTC */
-
-    /* Decode ion parameters */
-    a0  = R8(p,    e);
-    a1  = R8(p+8,  e);
-    a2  = R8(p+16, e);
-    a3  = R8(p+24, e);    
-    b0  = R8(p+32, e);
-    b1  = R8(p+40, e);
-    b2  = R8(p+48, e);
-    b3  = R8(p+56, e);
-
-    /* Decode utc parameters */
-    utc_wn  = U4(p+64, e);
-    tot     = U4(p+68, e);
-    A0      = R8(p+72, e);
-    A1      = R8(p+80, e);
-
-    /* Decode other parameters */
-    wn_lsf  = U4(p+88, e);
-    dn      = U4(p+92, e);
-    deltat_ls   = I4(p+96, e);
-    deltat_lsf  = I4(p+100, e);
-    deltat_utc  = U4(p+104, e);
-
-    /* update ion and utc parameters in raw->nav */
-    raw->nav.ion_gps[0] = a0;
-    raw->nav.ion_gps[1] = a1;
-    raw->nav.ion_gps[2] = a2;
-    raw->nav.ion_gps[3] = a3;
-    raw->nav.ion_gps[4] = b0;
-    raw->nav.ion_gps[5] = b1;
-    raw->nav.ion_gps[6] = b2;
-    raw->nav.ion_gps[7] = b3;
-
-    raw->nav.utc_gps[0] = A0;
-    raw->nav.utc_gps[1] = A1;
-    raw->nav.utc_gps[2] = tot;
-    raw->nav.utc_gps[3] = utc_wn;
+static void learn_bundle(bundle_t *bnd, unsigned int bits, int week, int ms)
+{
+    long long dt;
+    int k;
 
-    /* update leaps */
-    raw->nav.leaps = deltat_ls;
+    for (k = 0; k < NBNDMSG; k++)
+    {
+        if (bnd->ms[k] < 0) continue;
+        dt = (long long)(week - bnd->week[k]) * 604800000 + ms - bnd->ms[k];
 
-    return (9);
+        if (bits & (1u << k))
+        {
+            if (dt <= 0) continue;
+            if (dt < 604800000 && dt == bnd->tcand[k]) bnd->tint[k] = (int)dt;
+            bnd->tcand[k] = dt < 604800000 ? (int)dt : 0;
+        }
+        else if (bnd->tint[k] > 0 && dt > 3 * (long long)bnd->tint[k])
+        {
+            bnd->tint[k] = bnd->tcand[k] = 0;
+        }
+    }
+    for (k = 0; k < NBNDMSG; k++)
+    {
+        if (!(bits & (1u << k))) continue;
+        bnd->week[k] = week;
+        bnd->ms[k] = ms;
+    }
 }
 
 /*
-| Function: decode_range
-| Purpose:  Decode a raw observation record
+| Function: bundle_set
+| Purpose:  Get the set of messages expected at an epoch
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   bnd = Epoch bundler                         [Input]
+|   ms  = Header ms of the epoch                [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
-|   raw->time
+|   <none>
 |
 | Implicit outputs:
 |
-|   raw->obs
-|   raw->antno
+|   <none>
 |
 | Return Value:
 |
-|   -1: error message
-|    0: no message (tells caller to please read more data from the stream)
-|    1: input observation data
-|    2: input ephemeris
-|    3: input sbas message
-|    9: input ion/utc parameter
-|   11: input observation data (heading antenna)
+|   Messages expected (BND???), 0: none learned
 |
 | Design Issues:
 |
-|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
-|   See UnicoreComm command information reference manual V7.7.
+|   A message is expected at the epochs on the grid of its interval, as the
+|   receiver logs are aligned to the interval (e.g. ONTIME 0.2).
 */
-static int decode_range(raw_t *raw, int e)
+static unsigned int bundle_set(const bundle_t *bnd, int ms)
 {
-    typedef union {                             /* for analyse tracking status */
-        unsigned int u;
-        unsigned char c[4];
-    } track_t;
+    unsigned int set = 0;
+    int k;
 
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    int i, j, k;
-    int nobs;                                   /* observation number*/
-    int sat, prn;                               /* satellite number, prn */
-    unsigned char sys;                          /* satellite system */
-    double psr, adr;                            /* pseudo range (m)/ carrier phase obs (cycle) */
-    float dopp, cno;                            /* instant doppler (Hz)/ carrier noise ratio (dB-Hz)*/
-    unsigned char code;                         /* code indicator (CODE_??)*/
-    track_t ch_tr_status;                       /* channel tracking status 32 bits */
-    unsigned char tmp;                          /* for ch_tr_status parsing */
-    unsigned char *pp = NULL;                   /* pointer of the start for each obs */
-    int nfreq;                                  /* frequency number e.g. L[nfreq] */
-    int prnFlag;                                /* to check if this prn already has a record */
-    
-    /* Get the number of observations in this epoch */
-    nobs    = I4(p, e); 
-    /* Reset the number of obs in this epoch */
-    raw->obs.n = 0;
-    /* Read obs one by one */
-    for(i=0; i<nobs; i++)
+    for (k = 0; k < NBNDMSG; k++)
     {
-        /* reset the pointer for the start of current obs */
-        pp = p + 4 + i*44;  /* H + nobs + #obs*44 */        
-        /* Get prn */
-        prn = U2(pp, e);
-        if (38<=prn && prn<=62) prn = prn - 37;     /* GLONASS */
-        else if (161<=prn && prn<=197 ) prn = prn -160;  /* BDS */
-        /* ignore glofreq for glonass */
-
-        /* Get pseduo range */
-        psr = R8(pp+8-4, e);
-        /* Get carrier phase */
-        adr = R8(pp+20-4, e) * (-1.0); /* multiply by -1.0 to get non-negative value */
-        /* Get instant doppler obs */
-        dopp = R4(pp+32-4, e);
-        /* Get carrier noise ratio */
-        cno = R4(pp+36-4, e);
-        /* Get channel tracking status without endian conversion */
-        for(j=0; j<4; j++)
-            ch_tr_status.c[j] = *(pp+44-4+j);   /* c[0] is earlier than c[3] */
-
-        /* Get satellite system */
-        tmp = (unsigned char)(ch_tr_status.u >> 16) & 0x07; /* 0000 0111 */
-        switch(tmp)
-        {
-        case 0:
-            sys = SYS_GPS;
-            break;
-        case 1:
-            sys = SYS_GLO;
-            break;
-        case 4:
-            sys = SYS_BDS;
-            break;
-        default:
-            trace(0, "Unkown Satellite System!\n");
-            return (0);
-        }
-
-        /* Get frequency number for the current system */
-        tmp = (unsigned char)(ch_tr_status.u >> 21) & 0x1F; /* 0001 1111 */
-        if(sys == SYS_GPS) {
-            if(tmp == 0) {
-                nfreq = 0;
-                code  = CODE_L1C;
-            }
-            else if(tmp == 5 || tmp == 9) {
-                nfreq = 1;
-                code  = CODE_L2P;
-            }/* L2P || L2P codeness */
-            else if(tmp == 17) {
-                nfreq = 1;
-                code  = CODE_L2C;
-            }
-            else if(tmp == 14) {
-                nfreq = 2;
-                code  = CODE_L5Q;
-            }
-            else { 
-                trace(0,"GPS Frequency Recorgnise Error!\n");
-                return (0); 
-            }
-        }
-        else if(sys == SYS_GLO) {
-            if(tmp == 0) {
-                nfreq = 0;
-                code  = CODE_L1C;
-            }
-            else if(tmp == 5) {
-                nfreq = 1;
-                code  = CODE_L2P;
-            }
-            else {
-                trace(0, "GLO Frequency Recorgnise Error!\n");
-                return (0);
-            }
-        }
-        else if(sys == SYS_BDS) {
-            if(tmp == 0)        /* B1 */
-                nfreq = 0;
-            else if(tmp == 17)  /* B2 */
-                nfreq = 1;
-            else if(tmp == 21)  /* B3 */
-                nfreq = 2;
-            else {
-                trace(0, "BDS Frequency Recorgnise Error!\n");
-                return (0); 
-            }
-        }
-
-        /* Update obs in raw */
-        prnFlag = 0;
-        sat = satno(sys, prn);
-        for(k=0; k<raw->obs.n; k++) /* To find if the satellite already has a record */
-            if ( raw->obs.data[k].sat == sat ) {
-                    prnFlag = 1;    /* found one */
-                    break;
-            }
-        if( !prnFlag )  /* not found, then add a new record */
-            k = raw->obs.n++;
-        raw->obs.data[k].sat = sat;
-        raw->obs.data[k].time= raw->time;
-        raw->obs.data[k].P[nfreq] = psr;
-        raw->obs.data[k].L[nfreq] = adr;
-        raw->obs.data[k].D[nfreq] = dopp;
-        raw->obs.data[k].SNR[nfreq] = floor(cno*4.0); /* refs to definition */
-        raw->obs.data[k].code[nfreq]= code;
+        if (bnd->tint[k] > 0 && ms % bnd->tint[k] == 0) set |= 1u << k;
     }
-
-    /* Set antenna number for current obs */
-    raw->antno = 0;
-
-    return (1);
+    return (set);
 }
 
 /*
-| Function: decode_rangeh
-| Purpose:  Decode a raw observation record of the heading antenna
+| Function: out_bundle
+| Purpose:  Output an epoch bundle to the raw data control structure
 | Authors:  Guangli Dong
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   raw = Receiver raw data control structure   [Input/Output]
+|   ep  = Epoch bundle                          [Input/Output]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
-|   raw->time
+|   <none>
 |
 | Implicit outputs:
 |
 |   raw->obs
-|   raw->antno
+|   raw->obuf
+|   raw->gsof
+|   raw->tobs
+|   raw->bnd.mask
+|   raw->bnd.set
 |
 | Return Value:
 |
-|   -1: error message
-|    0: no message (tells caller to please read more data from the stream)
-|    1: input observation data
-|    2: input ephemeris
-|    3: input sbas message
-|    9: input ion/utc parameter
-|   11: input observation data (heading antenna)
+|   <none>
 |
 | Design Issues:
 |
-|   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
-|   See UnicoreComm command information reference manual V7.7.
+|   The observation buffers of the bundle are exchanged with raw->obs and
+|   raw->obuf, the bundle is emptied.
 */
-static int decode_rangeh(raw_t *raw, int e)
+static void out_bundle(raw_t *raw, bndep_t *ep)
 {
-    int status;
+    obs_t tmp;
 
-    if(status=decode_range(raw, e) == 1) {
-        raw->antno = 1; /* set the antenna number for current obs */
-        return (11);
+    tmp = raw->obs;  raw->obs  = ep->obs[0]; ep->obs[0] = tmp;
+    tmp = raw->obuf; raw->obuf = ep->obs[1]; ep->obs[1] = tmp;
+    if (!(ep->mask & BNDRANGE))  raw->obs.n  = 0;
+    if (!(ep->mask & BNDRANGEH)) raw->obuf.n = 0;
+
+    if (ep->mask & BNDPOS) raw->gsof.pos = ep->gsof.pos;
+    if (ep->mask & BNDVEL) raw->gsof.vel = ep->gsof.vel;
+    if (ep->mask & BNDATT) raw->gsof.att = ep->gsof.att;
+    if (ep->mask & BNDSAT)
+    {
+        raw->gsof.sat.num = ep->gsof.sat.num < MAXOBS ?
+                             ep->gsof.sat.num : MAXOBS;
+        memcpy(raw->gsof.sat.data, ep->gsof.sat.data,
+               sizeof(gsof_satd_t) * raw->gsof.sat.num);
     }
-    
-    return (status);
+    raw->tobs = ep->time;
+    raw->bnd.mask = ep->mask;
+    raw->bnd.set  = bundle_set(&raw->bnd, ep->ms);
+    ep->mask = 0;
 }
 
 /*
@@ -1298,12 +4664,13 @@ static int decode_rangeh(raw_t *raw, int e)
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   <none>
 |
 | Implicit outputs:
 |
@@ -1320,32 +4687,21 @@ static int decode_rangeh(raw_t *raw, int e)
 |   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
 |   See UnicoreComm command information reference manual V7.7.
 */
-static int decode_attitude(raw_t *raw, int e)
+static INLINE int decode_attitude(raw_t *raw, const unsigned char *buff,
+                              int e)
 {
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    double  len, heading, pitch;
-    float   heading_sig, pitch_sig;
-
-    /* Get length */
-    len     = (double)R4(p+8, e);
-    /* Get heading */
-    heading = (double)R4(p+12, e);
-    heading_sig = R4(p+24, e);
-    /* Get picth */
-    pitch   = (double)R4(p+16, e);
-    pitch_sig   = R4(p+28, e);
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
 
-    /* check the sigma value is acceptable 
-    if(heading_sig >= 0.2)
-        return (0); */
+    /* Check the message length */
+    if (raw->len-header_len-4 < heading_len)
+    {
+        trace(2, "unicore: gsof attitude length error, len=%d.\n", raw->len);
+        return (-1);
+    }
 
     /* Update gsof attitude data */
-    raw->gsof.att.length = len;
-    raw->gsof.att.heading= heading;
-    raw->gsof.att.heading_sig = heading_sig;
-    raw->gsof.att.pitch  = pitch;
-    raw->gsof.att.pitch_sig = pitch_sig;
+    get_heading(&raw->gsof.att, p, e);
 
     return (23);
 }
@@ -1357,12 +4713,13 @@ static int decode_attitude(raw_t *raw, int e)
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   <none>
 |
 | Implicit outputs:
 |
@@ -1379,26 +4736,21 @@ static int decode_attitude(raw_t *raw, int e)
 |   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
 |   See UnicoreComm command information reference manual V7.7.
 */
-static int decode_position(raw_t *raw, int e)
+static INLINE int decode_position(raw_t *raw, const unsigned char *buff,
+                              int e)
 {
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    double  lat, lon, hgt, undulation;
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
 
-    /* Get latitude */
-    lat = R8(p+8, e);
-    /* Get longitude */
-    lon = R8(p+16, e);
-    /* Get geoid height */
-    hgt = R8(p+24, e);
-    /* Get undulation */
-    undulation = (double)R4(p+32, e);
+    /* Check the message length */
+    if (raw->len-header_len-4 < psrpos_len)
+    {
+        trace(2, "unicore: gsof position length error, len=%d.\n", raw->len);
+        return (-1);
+    }
 
     /* Update gsof position data */
-    raw->gsof.pos.lat = lat;
-    raw->gsof.pos.lon = lon;
-    raw->gsof.pos.hgt = hgt;
-    raw->gsof.pos.undulation = undulation;
+    get_psrpos(&raw->gsof.pos, p, e);
 
     return (21);
 }
@@ -1410,12 +4762,13 @@ static int decode_position(raw_t *raw, int e)
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   <none>
 |
 | Implicit outputs:
 |
@@ -1432,23 +4785,21 @@ static int decode_position(raw_t *raw, int e)
 |   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
 |   See UnicoreComm command information reference manual V7.7.
 */
-static int decode_velocity(raw_t *raw, int e)
+static INLINE int decode_velocity(raw_t *raw, const unsigned char *buff,
+                              int e)
 {
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    double  hspd, vspd, heading;
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
 
-    /* Get horizontal speed */
-    hspd = R8(p+16, e);
-    /* Get horizontal speed direction relative to True North */
-    heading = R8(p+24, e);
-    /* Get vertical speed */
-    vspd = R8(p+32, e);
+    /* Check the message length */
+    if (raw->len-header_len-4 < psrvel_len)
+    {
+        trace(2, "unicore: gsof velocity length error, len=%d.\n", raw->len);
+        return (-1);
+    }
 
     /* Update gsof velocity data */
-    raw->gsof.vel.hspd = hspd;
-    raw->gsof.vel.vspd = vspd;
-    raw->gsof.vel.heading = heading;
+    get_psrvel(&raw->gsof.vel, p, e);
 
     return (22);
 }
@@ -1460,11 +4811,11 @@ static int decode_velocity(raw_t *raw, int e)
 | Author  : Guangli Dong
 | 
 | Formal parameter:
-|   raw = receiver raw data control [INPUT]
-|   fp  = output binary file        [INPUT] [OUTPUT]
+|   raw  = receiver raw data control [INPUT]
+|   buff = rangeh packet data        [INPUT]
+|   fp   = output binary file        [INPUT] [OUTPUT]
 |
 | Implict input:
-|   raw->buff[]
 |   raw->len
 |
 | Return value:
@@ -1479,9 +4830,13 @@ static int decode_velocity(raw_t *raw, int e)
 */ 
 /* option for convert rangeh data to range -----------------------------------*/
 #ifdef RANGEH_RANGE
-static int rangeh2range(raw_t *raw, FILE *fp)
+static int rangeh2range(raw_t *raw, const unsigned char *buff, FILE *fp)
 {
     unsigned int newcrc32;
+
+    /* packet decoded in place, take a copy to patch */
+    if (buff != raw->buff) memmove(raw->buff, buff, raw->len);
+
     /* change the msg id from 6005 to 43 */
     raw->buff[4] = 0x2B;
     raw->buff[5] = 0x00; 
@@ -1490,7 +4845,7 @@ static int rangeh2range(raw_t *raw, FILE *fp)
        need to use a union type to get every char of unsigned int */
 
     /* re-calculate CRC32 checksum */
-    newcrc32 = crc32(raw->buff, raw->len-4);
+    newcrc32 = crc32_update(0, raw->buff, raw->len-4);
 
     /* write binary data */
     fwrite(raw->buff, sizeof(unsigned char), raw->len-4, fp);
@@ -1507,12 +4862,13 @@ static int rangeh2range(raw_t *raw, FILE *fp)
 |
 | Formal Parameters: 
 |
-|   raw = Receiver raw data control structure [Input]
-|   endian = Endianness indicator             [Input]
+|   raw    = Receiver raw data control structure [Input]
+|   buff   = Packet frame (header+message+CRC)  [Input]
+|   endian = Endianness indicator                [Input]
 |
 | Implicit Inputs:
 |
-|   raw->buff[]
+|   <none>
 |
 | Implicit outputs:
 |
@@ -1529,16 +4885,32 @@ static int rangeh2range(raw_t *raw, FILE *fp)
 |   See BeiDou ICD V2.0 for documentation of the BDS satellite ephemeris.
 |   See UnicoreComm command information reference manual V7.7.
 */
-static int decode_satvis(raw_t *raw, int e)
+static INLINE int decode_satvis(raw_t *raw, const unsigned char *buff,
+                              int e)
 {
-    unsigned char header_len = (raw->buff[3]);  /* length of record header */
-    unsigned char *p = raw->buff + header_len;  /* set p point to the message data */
-    int sum, prn, sys, satnum, i;
+    unsigned char header_len = (buff[3]);       /* length of record header */
+    const unsigned char *p = buff + header_len; /* set p point to the message data */
+    int sum, prn, sys, satnum, i, n;
     double azi, ele;
 
-    /* get total satellites in vision */
-    sum = U4(p+8, e);
-    raw->gsof.sat.num = sum;
+    /* Check the message length */
+    if (raw->len-header_len-4 < 12)
+    {
+        trace(2, "unicore: gsof satvis length error, len=%d.\n", raw->len);
+        return (-1);
+    }
+
+    /* get total satellites in vision, bounded by body and MAXOBS */
+    sum = (int)U4(p+8, e);
+    n = (raw->len-header_len-4-12)/40;
+    if (n > MAXOBS) n = MAXOBS;
+    if (sum < 0 || sum > n)
+    {
+        trace(2, "unicore: gsof satvis number error, sum=%d len=%d.\n",
+              sum, raw->len);
+        sum = sum < 0 ? 0 : n;
+    }
+    raw->gsof.sat.num = (unsigned char)sum;
 
     /* get data records */
     for (i =0; i<sum; i++) {
@@ -1556,6 +4928,10 @@ static int decode_satvis(raw_t *raw, int e)
             prn = satnum - 160; 
             sys = SYS_BDS;
         }
+        else {                                     /* unknown */
+            prn = 0;
+            sys = SYS_NONE;
+        }
 
         /* get elevation angle */
         ele = R8(p+40*i+20, e);
@@ -32,7 +32,7 @@ int main(int argc, char *argv[])
         trace(0, "%s\n\n", "ERROR: memory allocation error!");
         return 0;
     }
-    strcpy(raw->opt, "-LE");    /* the file type is set to LITTLE_ENDIAN */
+    setopt_raw(raw, "-LE");     /* the file type is set to LITTLE_ENDIAN */
     raw->outtype    = 1;        /* set to output message type id */
 
     /* initialize socket */
@@ -61,11 +61,13 @@ int main(int argc, char *argv[])
 static void decode_stream(raw_t *raw, unsigned char buff[], int len)
 {
     /* local variable */
-    int i, j, status;
+    int j, status;
     int sys, prn;
+    size_t i, n;
     gtime_t utctimebj;
-    for (i=0; i<len; i++) {
-        status = decode_unicore(raw, buff[i]);
+    if (len <= 0) return;
+    for (i=0; i<(size_t)len; i+=n) {
+        status = decode_unicore_buf(raw, buff+i, len-i, &n);
         if (status <= 0) continue;
         /* get beijing utc time */
         utctimebj = gpst2utc(raw->time);
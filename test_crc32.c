@@ -0,0 +1,119 @@
+/* ----------------------------------------------------------------------------
+ * test_crc32.c : to test crc-32 engines against crc32()
+ *
+ * author : Guangli Dong
+ *
+ * history: 2026/10/16 new
+ *
+ * usage  : test_crc32
+ *
+ *          crc32_s8(), crc32_s16(), crc32_pclmul() and crc32_update() are
+ *          compared with the bitwise crc32() over data of 0 to MAXTESTLEN
+ *          bytes, at start offsets 0 to 15 and updated in one call or split
+ *          in two. crc32_pclmul() is only tested on a cpu supporting
+ *          pclmulqdq and sse4.1. Exits with 1 on any mismatch.
+ *
+ * ---------------------------------------------------------------------------*/
+
+#include "decode.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define MAXTESTLEN  2048                /* max data length to test (bytes) */
+#define MAXOFFSET   16                  /* start offsets to test (bytes) */
+
+typedef unsigned int (*crcfunc_t)(unsigned int crc, const unsigned char *buff,
+                                  int len);
+
+typedef struct {        /* crc-32 engine to test */
+    const char *name;   /* engine name */
+    crcfunc_t func;     /* engine function */
+    int use;            /* tested on this cpu (0:no,1:yes) */
+} engine_t;
+
+/* internal function forward declaration -------------------------------------*/
+static int cpu_pclmul(void);
+static int test_engine(const engine_t *eng, const unsigned char *data);
+
+int main(void)
+{
+    /* local variables */
+    static unsigned char data[MAXTESTLEN+MAXOFFSET];
+    engine_t eng[] = {
+        {"crc32_s8",     crc32_s8,     1},
+        {"crc32_s16",    crc32_s16,    1},
+        {"crc32_pclmul", crc32_pclmul, 0},
+        {"crc32_update", crc32_update, 1}
+    };
+    unsigned int x = 2463534242u;
+    int i, nerr = 0;
+
+    /* pseudo random test data (xorshift32) */
+    for (i=0; i<(int)sizeof(data); i++) {
+        x ^= x<<13; x ^= x>>17; x ^= x<<5;
+        data[i] = (unsigned char)(x>>24);
+    }
+    eng[2].use = cpu_pclmul();
+
+    for (i=0; i<(int)(sizeof(eng)/sizeof(eng[0])); i++) {
+        if (!eng[i].use) {
+            printf("%-13s: skipped, no cpu support\n", eng[i].name);
+            continue;
+        }
+        nerr += test_engine(eng+i, data);
+    }
+    printf("crc32_update engine: %s\n", crc32_engine());
+    printf("%s\n", nerr ? "NG" : "OK");
+
+    return nerr ? 1 : 0;
+}
+
+/* test a crc-32 engine over whole and split lengths -------------------------*/
+static int test_engine(const engine_t *eng, const unsigned char *data)
+{
+    const unsigned char *p;
+    unsigned int ref, crc;
+    int off, len, k, nerr = 0;
+
+    for (off=0; off<MAXOFFSET; off++) {
+        p = data+off;
+        for (len=0; len<=MAXTESTLEN; len++) {
+            ref = crc32(p, len);
+
+            /* whole length */
+            if ((crc = eng->func(0, p, len)) != ref) {
+                if (nerr++ < 10) {
+                    printf("%s: off=%d len=%d crc=%08X ref=%08X\n", eng->name,
+                           off, len, crc, ref);
+                }
+            }
+            /* split lengths */
+            for (k=1; k<len; k+=off>0?97:(k<80?1:31)) {
+                crc = eng->func(eng->func(0, p, k), p+k, len-k);
+                if (crc == ref) continue;
+                if (nerr++ < 10) {
+                    printf("%s: off=%d len=%d split=%d crc=%08X ref=%08X\n",
+                           eng->name, off, len, k, crc, ref);
+                }
+            }
+        }
+    }
+    printf("%-13s: %s (%d errors)\n", eng->name, nerr ? "NG" : "OK", nerr);
+    return nerr;
+}
+
+/* cpu support of pclmulqdq and sse4.1 ---------------------------------------*/
+static int cpu_pclmul(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2]&(1<<1)) && (info[2]&(1<<19));
+#else
+    return 1; /* same as crc32_s16() without pclmulqdq */
+#endif
+}
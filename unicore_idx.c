@@ -0,0 +1,151 @@
+/* ----------------------------------------------------------------------------
+ * unicore_idx.c : build and query the frame index of unicore raw data logs
+ *
+ * author : Guangli Dong
+ *
+ * history: 2026/10/16 new
+ *
+ * usage  : unicore_idx [option ...] file
+ *
+ *          -LE         little-endian log (default: big-endian)
+ *          -o idxfile  index file (default: file.idx)
+ *          -f          rebuild the index even if it is up to date
+ *          -ts w tow   list frames from gps week w, time of week tow (s)
+ *          -te w tow   list frames before gps week w, time of week tow (s)
+ *          -m msgid    list frames of message id only
+ *          -d          decode the listed frames and print their status
+ *
+ *          without -ts/-te/-m/-d the index is only built and a summary of
+ *          message ids is printed.
+ *
+ * ---------------------------------------------------------------------------*/
+
+#include "decode.h"
+
+#define MAXMSGID    65536               /* number of message ids */
+
+/* internal function forward declaration -------------------------------------*/
+static int  load_index(raw_t *raw, rawfile_t *file, const char *path,
+                       rawindex_t *index, int force);
+static void print_usage(void);
+
+int main(int argc, char *argv[])
+{
+    /* local variables */
+    raw_t      *raw;
+    rawfile_t   file;
+    rawindex_t  index = {0};
+    gtime_t     ts = {0}, te = {0};
+    rawidx_t   *rec;
+    char        idxpath[1024] = "", opt[256] = "";
+    char       *infile = NULL;
+    int         i, status, msgid = -1, force = 0, decode = 0, list = 0;
+    static int  count[MAXMSGID];
+
+    for (i=1; i<argc; i++) {
+        if      (!strcmp(argv[i], "-LE")) strcpy(opt, "-LE");
+        else if (!strcmp(argv[i], "-o" ) && i+1<argc) {
+            strncpy(idxpath, argv[++i], sizeof(idxpath)-1);
+        }
+        else if (!strcmp(argv[i], "-f" )) force = 1;
+        else if (!strcmp(argv[i], "-ts") && i+2<argc) {
+            ts = gpst2time(atoi(argv[i+1]), atof(argv[i+2])); i += 2; list = 1;
+        }
+        else if (!strcmp(argv[i], "-te") && i+2<argc) {
+            te = gpst2time(atoi(argv[i+1]), atof(argv[i+2])); i += 2; list = 1;
+        }
+        else if (!strcmp(argv[i], "-m" ) && i+1<argc) {
+            msgid = atoi(argv[++i]); list = 1;
+        }
+        else if (!strcmp(argv[i], "-d" )) decode = list = 1;
+        else if (argv[i][0] == '-') {
+            print_usage();
+            return -1;
+        }
+        else infile = argv[i];
+    }
+    if (!infile) {
+        print_usage();
+        return -1;
+    }
+    if (!*idxpath) sprintf(idxpath, "%.1019s.idx", infile);
+
+    /* initialise raw */
+    raw = (raw_t *)malloc(sizeof(raw_t));
+    if (!raw || 0 == init_raw(raw))
+    {
+        trace(0, "%s\n\n", "ERROR: memory allocation error!");
+        return -1;
+    }
+    setopt_raw(raw, opt);
+
+    if (!open_rawfile(&file, infile)) {
+        fprintf(stderr, "file open error: %s\n", infile);
+        free_raw(raw); free(raw);
+        return -1;
+    }
+    if (!load_index(raw, &file, idxpath, &index, force)) {
+        close_rawfile(&file); free_raw(raw); free(raw);
+        return -1;
+    }
+
+    /* summary of message ids */
+    if (!list) {
+        for (i=0; i<index.n; i++) count[index.data[i].msgid]++;
+        printf("%s: %d frames\n", infile, index.n);
+        for (i=0; i<MAXMSGID; i++) {
+            if (count[i]) printf("  msgid %5d: %d\n", i, count[i]);
+        }
+    }
+    /* list and decode frames in time window */
+    else {
+        i = ts.time ? search_rawindex(&index, ts) : 0;
+        for (; i<index.n; i++) {
+            rec = index.data+i;
+            if (te.time && timediff(gpst2time(rec->week, rec->ms*1E-3), te) >= 0.0)
+                break;
+            if (msgid >= 0 && rec->msgid != msgid) continue;
+
+            printf("%14lld %5d %5d %4d %10.3f", rec->offset, rec->msgid,
+                   rec->len, rec->week, rec->ms*1E-3);
+            if (decode) {
+                status = decode_unicore_at(raw, &file, rec);
+                printf(" %3d", status);
+            }
+            printf("\n");
+        }
+    }
+
+    /* clear */
+    free_rawindex(&index);
+    close_rawfile(&file);
+    free_raw(raw);
+    free(raw);
+    return 0;
+}
+
+/* read the index file or build and write it if missing or stale ------------*/
+static int load_index(raw_t *raw, rawfile_t *file, const char *path,
+                      rawindex_t *index, int force)
+{
+    if (!force && read_rawindex(path, index)) {
+        if (index->size == file->size) return 1;
+        free_rawindex(index);
+    }
+    if (index_unicore(raw, file, index) < 0) {
+        fprintf(stderr, "index error: memory allocation error\n");
+        return 0;
+    }
+    if (!write_rawindex(path, index)) {
+        fprintf(stderr, "index file write error: %s\n", path);
+    }
+    return 1;
+}
+
+/* print usage ---------------------------------------------------------------*/
+static void print_usage(void)
+{
+    fprintf(stderr,
+        "usage: unicore_idx [-LE] [-o idxfile] [-f] [-ts w tow] [-te w tow]\n"
+        "                   [-m msgid] [-d] file\n");
+}